@@ -0,0 +1,217 @@
+#include "random_floor.h"
+#include "level.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const int SMOOTHING_PASSES = 4;
+
+// One bit per tile, set for wall, in rows of words_per_row 64-bit words (tile
+// x at bit x & 63 of word x >> 6). Rows are stored in pairs with their words
+// interleaved (row 2p word k, then row 2p + 1 word k), so one 128-bit load
+// holds the same word of two rows. The border, the bits past w and the row
+// past h when h is odd are wall.
+struct CaveBits {
+    int w, h, words_per_row, pairs;
+    std::vector<uint64_t> cells;
+
+    size_t word(int y, int k) const { return ((size_t)(y >> 1) * words_per_row + k) * 2 + (y & 1); }
+};
+
+// Bits of a word that stay wall in every row: the left and right border and
+// anything past w
+uint64_t edge_bits(int w, int k) {
+    uint64_t bits = 0;
+    if (k == 0)
+        bits |= 1;
+    const int last = w - 1 - k * 64;
+    if (last >= 0 && last < 64)
+        bits |= ~(uint64_t)0 << last; // the right border and beyond
+    return bits;
+}
+
+// Rows that stay wall: the top and bottom border and the padding row
+inline bool fixed_row(const CaveBits& b, int y) { return y == 0 || y >= b.h - 1; }
+
+template <typename V>
+inline void full_add(V a, V b, V c, V& sum, V& carry) {
+    const V t = a ^ b;
+    sum = t ^ c;
+    carry = (a & b) | (t & c);
+}
+
+// Cellular automaton step on every bit lane at once: wall where at least 5
+// of the 3x3 block are wall. l, c and r hold the block's rows (above, the
+// tile's own, below) lined up on the tile: its left neighbours, itself, its
+// right neighbours. The nine bits are summed with full adders.
+template <typename V>
+inline V smooth_cells(const V (&l)[3], const V (&c)[3], const V (&r)[3]) {
+    V ones[3], twos[3];
+    for (int i = 0; i < 3; ++i)
+        full_add(l[i], c[i], r[i], ones[i], twos[i]);
+    V u0, k0, t0, t1;
+    full_add(ones[0], ones[1], ones[2], u0, k0);
+    full_add(twos[0], twos[1], twos[2], t0, t1);
+    // count = u0 + 2 * (t0 + k0) + 4 * t1
+    const V v0 = t0 ^ k0, v1 = t0 & k0;
+    return (t1 & v1) | ((t1 | v1) & (v0 | u0));
+}
+
+#if defined(__SSE2__)
+// The two rows of a pair side by side, for smooth_cells()
+struct Lanes {
+    __m128i v;
+};
+inline Lanes operator&(Lanes a, Lanes b) { return {_mm_and_si128(a.v, b.v)}; }
+inline Lanes operator|(Lanes a, Lanes b) { return {_mm_or_si128(a.v, b.v)}; }
+inline Lanes operator^(Lanes a, Lanes b) { return {_mm_xor_si128(a.v, b.v)}; }
+
+// (a's second lane, b's first)
+inline __m128i straddle(__m128i a, __m128i b) {
+    return _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b), 1));
+}
+
+// Two rows per step: the pair's words are one vector, and the rows above and
+// below are the neighbouring pairs' vectors shifted by one lane
+void smooth_pass(const CaveBits& src, CaveBits& dst) {
+    const int wpr = src.words_per_row;
+    const __m128i wall = _mm_set1_epi32(-1);
+    for (int p = 0; p < src.pairs; ++p) {
+        const uint64_t* cur = &src.cells[src.word(2 * p, 0)];
+        const uint64_t* prev = p > 0 ? cur - 2 * wpr : nullptr;
+        const uint64_t* next = p + 1 < src.pairs ? cur + 2 * wpr : nullptr;
+        uint64_t* out = &dst.cells[dst.word(2 * p, 0)];
+        // Rows above, of and below the pair at word k; wall outside the row
+        auto column = [&](int k, __m128i (&col)[3]) {
+            if (k >= wpr) {
+                col[0] = col[1] = col[2] = wall;
+                return;
+            }
+            const __m128i m = _mm_loadu_si128((const __m128i*)(cur + 2 * k));
+            col[0] = straddle(prev ? _mm_loadu_si128((const __m128i*)(prev + 2 * k)) : wall, m);
+            col[1] = m;
+            col[2] = straddle(m, next ? _mm_loadu_si128((const __m128i*)(next + 2 * k)) : wall);
+        };
+        const __m128i fixed = _mm_set_epi64x(fixed_row(src, 2 * p + 1) ? -1 : 0, fixed_row(src, 2 * p) ? -1 : 0);
+        __m128i a[3] = {wall, wall, wall}, b[3], c[3];
+        column(0, b);
+        for (int k = 0; k < wpr; ++k) {
+            column(k + 1, c);
+            Lanes l[3], m[3], r[3];
+            for (int i = 0; i < 3; ++i) {
+                l[i].v = _mm_or_si128(_mm_slli_epi64(b[i], 1), _mm_srli_epi64(a[i], 63));
+                m[i].v = b[i];
+                r[i].v = _mm_or_si128(_mm_srli_epi64(b[i], 1), _mm_slli_epi64(c[i], 63));
+            }
+            __m128i v = smooth_cells(l, m, r).v;
+            v = _mm_or_si128(v, _mm_or_si128(fixed, _mm_set1_epi64x((long long)edge_bits(src.w, k))));
+            _mm_storeu_si128((__m128i*)(out + 2 * k), v);
+            for (int i = 0; i < 3; ++i) {
+                a[i] = b[i];
+                b[i] = c[i];
+            }
+        }
+    }
+}
+#else
+// One row per step
+void smooth_pass(const CaveBits& src, CaveBits& dst) {
+    const int wpr = src.words_per_row;
+    const uint64_t wall = ~(uint64_t)0;
+    for (int y = 0; y < src.pairs * 2; ++y) {
+        auto column = [&](int k, uint64_t (&col)[3]) {
+            if (k >= wpr) {
+                col[0] = col[1] = col[2] = wall;
+                return;
+            }
+            col[0] = y > 0 ? src.cells[src.word(y - 1, k)] : wall;
+            col[1] = src.cells[src.word(y, k)];
+            col[2] = y + 1 < src.pairs * 2 ? src.cells[src.word(y + 1, k)] : wall;
+        };
+        const uint64_t fixed = fixed_row(src, y) ? wall : 0;
+        uint64_t a[3] = {wall, wall, wall}, b[3], c[3];
+        column(0, b);
+        for (int k = 0; k < wpr; ++k) {
+            column(k + 1, c);
+            uint64_t l[3], r[3];
+            for (int i = 0; i < 3; ++i) {
+                l[i] = b[i] << 1 | a[i] >> 63;
+                r[i] = b[i] >> 1 | c[i] << 63;
+            }
+            dst.cells[dst.word(y, k)] = smooth_cells(l, b, r) | fixed | edge_bits(src.w, k);
+            for (int i = 0; i < 3; ++i) {
+                a[i] = b[i];
+                b[i] = c[i];
+            }
+        }
+    }
+}
+#endif
+
+// Eight tiles for each byte of a row
+struct TileBytes {
+    char tiles[256][8];
+
+    TileBytes() {
+        for (int i = 0; i < 256; ++i)
+            for (int b = 0; b < 8; ++b)
+                tiles[i][b] = (i >> b & 1) ? TILE_WALL : TILE_FLOOR;
+    }
+};
+
+} // namespace
+
+std::vector<std::string> generate_cave_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed, FloorGenStats* stats) {
+    FloorRng rng(seed ? seed : std::random_device{}());
+    CaveBits cur{w, h, (w + 63) / 64, (h + 1) / 2, {}};
+    cur.cells.resize((size_t)cur.pairs * 2 * cur.words_per_row);
+
+    // 1. Noise: each tile is wall with probability 7/16
+    uint64_t state = (uint64_t)rng() << 32 | rng();
+    for (int y = 0; y < cur.pairs * 2; ++y) {
+        for (int k = 0; k < cur.words_per_row; ++k) {
+            uint64_t bits = ~(uint64_t)0;
+            if (!fixed_row(cur, y)) {
+                const uint64_t a = splitmix64(state), b = splitmix64(state);
+                const uint64_t c = splitmix64(state), d = splitmix64(state);
+                bits = (a & (b | c | d)) | edge_bits(w, k);
+            }
+            cur.cells[cur.word(y, k)] = bits;
+        }
+    }
+
+    // 2. Smoothing
+    CaveBits next{w, h, cur.words_per_row, cur.pairs, std::vector<uint64_t>(cur.cells.size())};
+    for (int pass = 0; pass < SMOOTHING_PASSES; ++pass) {
+        smooth_pass(cur, next);
+        std::swap(cur.cells, next.cells);
+    }
+
+    // 3. Tiles, eight at a time
+    static const TileBytes bytes;
+    std::vector<std::string> map(h, std::string(w, TILE_WALL));
+    for (int y = 0; y < h; ++y) {
+        char* row = &map[y][0];
+        for (int k = 0; k < cur.words_per_row; ++k) {
+            const uint64_t bits = cur.cells[cur.word(y, k)];
+            for (int b = 0; b < 8; ++b) {
+                const int x = k * 64 + b * 8;
+                if (x >= w)
+                    break;
+                memcpy(row + x, bytes.tiles[bits >> (b * 8) & 255], std::min(8, w - x));
+            }
+        }
+    }
+
+    // 4. Doorways, and every cave joined up
+    finish_floor(map, rng, entrance_pos, exit_pos, stats);
+    if (stats)
+        stats->rooms = 0;
+    return map;
+}
@@ -0,0 +1,94 @@
+#include "column_cache.h"
+#include "level.h"
+#include "engine/workers.h"
+#include <algorithm>
+
+// Marks the columns that tile (tx, ty) can change: the ones whose ray
+// stopped on it, and the ones it now covers in front of their wall
+static void mark_tile(ColumnCache& cache, const Camera& cam, int tx, int ty) {
+    const int w = cache.view_w;
+    float inv_det = 1.0f / (cam.plane_x * cam.dir_y - cam.dir_x * cam.plane_y);
+    float min_sx = 1e30f, max_sx = -1e30f, near_depth = 1e30f;
+    int in_front = 0;
+    for (int c = 0; c < 4; ++c) {
+        float rel_x = tx + (c & 1) - cam.pos_x;
+        float rel_y = ty + (c >> 1) - cam.pos_y;
+        float trans_x = inv_det * (cam.dir_y * rel_x - cam.dir_x * rel_y);
+        float trans_y = inv_det * (-cam.plane_y * rel_x + cam.plane_x * rel_y);
+        if (trans_y <= 1e-4f)
+            continue;
+        ++in_front;
+        float sx = (w / 2) * (1 + trans_x / trans_y);
+        min_sx = std::min(min_sx, sx);
+        max_sx = std::max(max_sx, sx);
+        near_depth = std::min(near_depth, trans_y);
+    }
+    // Rays only travel forward, so a tile behind the camera plane is never hit
+    if (in_front == 0)
+        return;
+    int x0 = 0, x1 = w - 1;
+    if (in_front == 4) {
+        min_sx = std::max(min_sx, -1.0f);
+        max_sx = std::min(max_sx, (float)w);
+        x0 = std::max(0, (int)min_sx - 1);
+        x1 = std::min(w - 1, (int)max_sx + 1);
+    } else {
+        near_depth = 0; // straddles the camera plane: may cover any column
+    }
+    for (int x = x0; x <= x1; ++x) {
+        const RayHit& hit = cache.hits[x];
+        if ((hit.map_x == tx && hit.map_y == ty) || near_depth <= hit.perp_wall_dist)
+            cache.dirty[x] = 1;
+    }
+}
+
+const RayHit* column_cache_update(ColumnCache& cache, const Player& player, const Camera& cam,
+                                  int view_w, int tex_w) {
+    const std::vector<std::pair<int,int>>& changes = get_tile_changes();
+    bool same_pose = cache.x == player.x && cache.y == player.y && cache.dir == player.dir &&
+                     cache.view_w == view_w && cache.tex_w == tex_w &&
+                     cache.level_version == get_level_version() &&
+                     cache.changes_seen <= changes.size();
+    cache.columns_traced = 0;
+    if (!same_pose) {
+        cache.x = player.x;
+        cache.y = player.y;
+        cache.dir = player.dir;
+        cache.view_w = view_w;
+        cache.tex_w = tex_w;
+        cache.level_version = get_level_version();
+        cache.changes_seen = changes.size();
+        cache.hits.resize(view_w);
+        cache.dirty.assign(view_w, 0);
+        RayHit* hits = cache.hits.data();
+        engine::parallel_for(0, view_w, raycast_packet_width(), [&](int x0, int x1) {
+            cast_columns(cam, x0, x1, view_w, tex_w, hits);
+        });
+        cache.columns_traced = view_w;
+        return hits;
+    }
+    if (cache.changes_seen == changes.size())
+        return cache.hits.data();
+
+    // Same pose, edited map: re-trace only the affected columns
+    for (size_t i = cache.changes_seen; i < changes.size(); ++i)
+        mark_tile(cache, cam, changes[i].first, changes[i].second);
+    cache.changes_seen = changes.size();
+    for (int x = 0; x < view_w;) {
+        if (!cache.dirty[x]) {
+            ++x;
+            continue;
+        }
+        int end = x;
+        while (end < view_w && cache.dirty[end])
+            cache.dirty[end++] = 0;
+        cast_columns(cam, x, end, view_w, tex_w, cache.hits.data());
+        cache.columns_traced += end - x;
+        x = end;
+    }
+    return cache.hits.data();
+}
+
+void column_cache_clear(ColumnCache& cache) {
+    cache = ColumnCache();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "raycast.h"
+#include <vector>
+
+// Per-column ray hits for one camera pose. The player sits on whole tiles
+// and faces a cardinal direction, so while the pose holds still the hits
+// only change where the map does.
+struct ColumnCache {
+    int x = -1, y = -1, dir = -1;
+    int view_w = 0, tex_w = 0;
+    unsigned level_version = 0;
+    size_t changes_seen = 0;    // entries of get_tile_changes() already applied
+    std::vector<RayHit> hits;
+    std::vector<unsigned char> dirty;
+    int columns_traced = 0;     // columns re-traced by the last update
+};
+
+// Brings the cache up to date for the player's pose and returns the hits
+// (view_w entries). An unchanged pose traces nothing; tile edits re-trace
+// only the columns the edited tiles can affect.
+const RayHit* column_cache_update(ColumnCache& cache, const Player& player, const Camera& cam,
+                                  int view_w, int tex_w);
+
+void column_cache_clear(ColumnCache& cache);
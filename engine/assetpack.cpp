@@ -0,0 +1,119 @@
+#include "assetpack.h"
+#include "log.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+
+static const unsigned char* g_pack = nullptr;
+static size_t g_pack_size = 0;
+#ifdef _WIN32
+static std::vector<unsigned char> g_pack_storage; // no mmap: read it whole
+#endif
+
+static bool validate_pack() {
+    if (g_pack_size < sizeof(PackHeader))
+        return false;
+    const PackHeader* hdr = (const PackHeader*)g_pack;
+    if (memcmp(hdr->magic, PACK_MAGIC, 4) != 0 || hdr->version != PACK_VERSION ||
+        hdr->format != PACK_FORMAT_ARGB8888)
+        return false;
+    size_t tables = sizeof(PackHeader) + hdr->page_count * sizeof(PackPage) +
+                    hdr->entry_count * sizeof(PackEntry);
+    if (tables > g_pack_size)
+        return false;
+    const PackPage* pages = (const PackPage*)(g_pack + sizeof(PackHeader));
+    for (uint32_t i = 0; i < hdr->page_count; ++i)
+        if (pages[i].offset % 4 != 0 || pages[i].offset + (uint64_t)pages[i].w * pages[i].h * 4 > g_pack_size)
+            return false;
+    const PackEntry* entries = (const PackEntry*)(pages + hdr->page_count);
+    for (uint32_t i = 0; i < hdr->entry_count; ++i) {
+        const PackEntry& e = entries[i];
+        if (e.page >= hdr->page_count || e.x + e.w > pages[e.page].w || e.y + e.h > pages[e.page].h)
+            return false;
+    }
+    return true;
+}
+
+bool open_asset_pack(const char* path) {
+    close_asset_pack();
+#ifdef _WIN32
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    g_pack_storage.resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(g_pack_storage.data(), 1, size, f) == (size_t)size;
+    fclose(f);
+    if (!ok)
+        return false;
+    g_pack = g_pack_storage.data();
+    g_pack_size = g_pack_storage.size();
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    g_pack = (const unsigned char*)p;
+    g_pack_size = st.st_size;
+#endif
+    if (!validate_pack()) {
+        LOG_WARN(Assets, "Ignoring invalid asset pack: %s", path);
+        close_asset_pack();
+        return false;
+    }
+    return true;
+}
+
+void close_asset_pack() {
+#ifdef _WIN32
+    g_pack_storage.clear();
+#else
+    if (g_pack)
+        munmap((void*)g_pack, g_pack_size);
+#endif
+    g_pack = nullptr;
+    g_pack_size = 0;
+}
+
+bool asset_pack_open() { return g_pack != nullptr; }
+
+bool find_pack_image(const char* name, PackImage& out) {
+    if (!g_pack)
+        return false;
+    const PackHeader* hdr = (const PackHeader*)g_pack;
+    const PackPage* pages = (const PackPage*)(g_pack + sizeof(PackHeader));
+    const PackEntry* entries = (const PackEntry*)(pages + hdr->page_count);
+    for (uint32_t i = 0; i < hdr->entry_count; ++i) {
+        const PackEntry& e = entries[i];
+        if (strncmp(e.name, name, sizeof(e.name)) != 0)
+            continue;
+        const PackPage& page = pages[e.page];
+        const uint32_t* base = (const uint32_t*)(g_pack + page.offset);
+        out.pixels = base + (size_t)e.y * page.w + e.x;
+        out.w = e.w;
+        out.h = e.h;
+        out.pitch = page.w;
+        return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+// Asset pack: images decoded at build time (tools/pack_assets.cpp) into the
+// renderer's native ARGB8888 layout, memory-mapped at startup
+#include <cstdint>
+
+namespace engine {
+    constexpr char PACK_MAGIC[4] = {'M', 'V', 'P', 'K'};
+    constexpr uint32_t PACK_VERSION = 1;
+    constexpr uint32_t PACK_FORMAT_ARGB8888 = 0x16362004; // SDL_PIXELFORMAT_ARGB8888
+
+    // File layout (little-endian): header, page table, entry table, then the
+    // pages' pixel data, each 64-byte aligned with a pitch of w * 4 bytes
+    struct PackHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t format;
+        uint32_t page_count;
+        uint32_t entry_count;
+        uint32_t reserved[3];
+    };
+    struct PackPage {
+        uint32_t w, h;
+        uint64_t offset;
+    };
+    // Atlas rectangle of one named image within a page
+    struct PackEntry {
+        char name[48];
+        uint32_t page;
+        uint32_t x, y, w, h;
+    };
+
+    // Pixels of one image, pointing into the mapped pack
+    struct PackImage {
+        const uint32_t* pixels = nullptr; // first pixel of the rectangle
+        int w = 0, h = 0;
+        int pitch = 0;                    // in pixels
+    };
+
+    // Maps the pack at path; false (and no error) when it does not exist
+    bool open_asset_pack(const char* path);
+    void close_asset_pack();
+    bool asset_pack_open();
+    // Looks an image up by name (e.g. "wall.png")
+    bool find_pack_image(const char* name, PackImage& out);
+}
@@ -0,0 +1,215 @@
+#include "log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+const char* const CATEGORY_NAMES[] = {"general", "render", "assets", "game", "profiler"};
+
+// One formatted message. Fixed-size slots keep the ring trivially SPSC.
+constexpr size_t SLOT_SIZE = 256;
+struct Slot {
+    uint64_t ns;
+    uint8_t level, cat;
+    uint16_t len;
+    char text[SLOT_SIZE - 12];
+};
+
+// Single producer (the owning thread) / single consumer (the writer). A full
+// ring drops the message and counts it rather than blocking the caller.
+constexpr uint32_t RING_SLOTS = 1024;
+struct LogRing {
+    Slot slots[RING_SLOTS];
+    std::atomic<uint32_t> head{0}; // next write, owned by the producer
+    std::atomic<uint32_t> tail{0}; // next read, owned by the writer
+    std::atomic<uint32_t> dropped{0};
+};
+
+// Rings live until exit: a thread's ring outlives the thread
+std::mutex g_rings_mutex;
+std::vector<std::unique_ptr<LogRing>> g_rings;
+thread_local LogRing* t_ring = nullptr;
+
+std::atomic<int> g_min_level{(int)LogLevel::Debug};
+std::atomic<uint32_t> g_category_mask{~0u};
+std::atomic<bool> g_running{false};
+std::thread g_writer;
+std::mutex g_wake_mutex;
+std::condition_variable g_wake;
+bool g_stop = false;
+FILE* g_out = nullptr;
+std::mutex g_sync_mutex; // synchronous writes before init / after shutdown
+
+const auto g_epoch = std::chrono::steady_clock::now();
+
+// How long the writer sleeps between batches unless a warning wakes it
+const auto WRITER_INTERVAL = std::chrono::milliseconds(50);
+
+uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch)
+        .count();
+}
+
+LogRing* thread_ring() {
+    if (!t_ring) {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        g_rings.push_back(std::make_unique<LogRing>());
+        t_ring = g_rings.back().get();
+    }
+    return t_ring;
+}
+
+void append_line(std::string& out, const Slot& s) {
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "%10.3f %-5s %-8s ", s.ns * 1e-6, LEVEL_NAMES[s.level], CATEGORY_NAMES[s.cat]);
+    out += prefix;
+    out.append(s.text, s.len);
+    out += '\n';
+}
+
+// Moves every queued message out of the rings, oldest first, in one write
+void drain(FILE* out) {
+    std::vector<LogRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        for (auto& r : g_rings)
+            rings.push_back(r.get());
+    }
+    std::vector<Slot> batch;
+    uint32_t dropped = 0;
+    for (LogRing* r : rings) {
+        uint32_t tail = r->tail.load(std::memory_order_relaxed);
+        const uint32_t head = r->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+            batch.push_back(r->slots[tail % RING_SLOTS]);
+        r->tail.store(tail, std::memory_order_release);
+        dropped += r->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    if (batch.empty() && dropped == 0)
+        return;
+    std::stable_sort(batch.begin(), batch.end(), [](const Slot& a, const Slot& b) { return a.ns < b.ns; });
+    std::string text;
+    text.reserve(batch.size() * 96);
+    for (const Slot& s : batch)
+        append_line(text, s);
+    if (dropped)
+        text += "log: " + std::to_string(dropped) + " messages dropped (ring full)\n";
+    fwrite(text.data(), 1, text.size(), out);
+    fflush(out);
+}
+
+void writer_main() {
+    std::unique_lock<std::mutex> lock(g_wake_mutex);
+    while (!g_stop) {
+        g_wake.wait_for(lock, WRITER_INTERVAL);
+        lock.unlock();
+        drain(g_out);
+        lock.lock();
+    }
+}
+
+} // namespace
+
+bool log_init(const char* path, LogLevel min_level) {
+    if (g_running.load())
+        return true;
+    log_set_level(min_level);
+    g_out = stderr;
+    bool ok = true;
+    if (path) {
+        FILE* f = fopen(path, "w");
+        if (f)
+            g_out = f;
+        else
+            ok = false;
+    }
+    g_stop = false;
+    g_writer = std::thread(writer_main);
+    g_running.store(true);
+    if (!ok)
+        LOG_ERROR(General, "Cannot open log file %s, logging to stderr", path);
+    return ok;
+}
+
+void log_shutdown() {
+    if (!g_running.exchange(false))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_stop = true;
+    }
+    g_wake.notify_one();
+    g_writer.join();
+    drain(g_out);
+    if (g_out != stderr)
+        fclose(g_out);
+    g_out = nullptr;
+}
+
+void log_set_level(LogLevel min_level) { g_min_level.store((int)min_level, std::memory_order_relaxed); }
+
+void log_set_category_enabled(LogCategory cat, bool enabled) {
+    if (enabled)
+        g_category_mask.fetch_or(1u << (int)cat, std::memory_order_relaxed);
+    else
+        g_category_mask.fetch_and(~(1u << (int)cat), std::memory_order_relaxed);
+}
+
+bool log_enabled(LogLevel level, LogCategory cat) {
+    return (int)level >= g_min_level.load(std::memory_order_relaxed) &&
+           (g_category_mask.load(std::memory_order_relaxed) >> (int)cat & 1u);
+}
+
+void log_write(LogLevel level, LogCategory cat, const char* fmt, ...) {
+    if (!log_enabled(level, cat))
+        return;
+    va_list args;
+    va_start(args, fmt);
+    if (!g_running.load(std::memory_order_acquire)) {
+        Slot s;
+        s.ns = now_ns();
+        s.level = (uint8_t)level;
+        s.cat = (uint8_t)cat;
+        int n = vsnprintf(s.text, sizeof(s.text), fmt, args);
+        s.len = (uint16_t)std::min<int>(std::max(n, 0), sizeof(s.text) - 1);
+        std::string line;
+        append_line(line, s);
+        std::lock_guard<std::mutex> lock(g_sync_mutex);
+        fputs(line.c_str(), stderr);
+        va_end(args);
+        return;
+    }
+    LogRing* r = thread_ring();
+    uint32_t head = r->head.load(std::memory_order_relaxed);
+    if (head - r->tail.load(std::memory_order_acquire) >= RING_SLOTS) {
+        r->dropped.fetch_add(1, std::memory_order_relaxed);
+        va_end(args);
+        return;
+    }
+    Slot& s = r->slots[head % RING_SLOTS];
+    s.ns = now_ns();
+    s.level = (uint8_t)level;
+    s.cat = (uint8_t)cat;
+    int n = vsnprintf(s.text, sizeof(s.text), fmt, args);
+    s.len = (uint16_t)std::min<int>(std::max(n, 0), sizeof(s.text) - 1);
+    va_end(args);
+    r->head.store(head + 1, std::memory_order_release);
+    // Problems show up promptly and a filling ring is drained early; routine
+    // messages otherwise wait for the next batch
+    if (level >= LogLevel::Warn || head + 1 - r->tail.load(std::memory_order_relaxed) >= RING_SLOTS / 2)
+        g_wake.notify_one();
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+// Leveled, categorized logging. A message is formatted on the calling thread
+// into that thread's lock-free ring; a background writer drains the rings
+// and writes them in batches to a file or stderr. Debug messages compile out
+// when NDEBUG is defined (release builds).
+#include <cstdarg>
+
+namespace engine {
+    enum class LogLevel { Debug, Info, Warn, Error };
+    enum class LogCategory { General, Render, Assets, Game, Profiler, Count };
+
+    // Starts the writer thread. path == nullptr writes to stderr. Before this
+    // (and after log_shutdown) messages are written synchronously.
+    bool log_init(const char* path, LogLevel min_level);
+    // Flushes everything logged so far and stops the writer
+    void log_shutdown();
+
+    void log_set_level(LogLevel min_level);
+    void log_set_category_enabled(LogCategory cat, bool enabled);
+    bool log_enabled(LogLevel level, LogCategory cat);
+
+    // printf-style; messages longer than a ring slot are truncated
+    void log_write(LogLevel level, LogCategory cat, const char* fmt, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+}
+
+#ifdef NDEBUG
+#define LOG_DEBUG(cat, ...) ((void)0)
+#else
+#define LOG_DEBUG(cat, ...) engine::log_write(engine::LogLevel::Debug, engine::LogCategory::cat, __VA_ARGS__)
+#endif
+#define LOG_INFO(cat, ...) engine::log_write(engine::LogLevel::Info, engine::LogCategory::cat, __VA_ARGS__)
+#define LOG_WARN(cat, ...) engine::log_write(engine::LogLevel::Warn, engine::LogCategory::cat, __VA_ARGS__)
+#define LOG_ERROR(cat, ...) engine::log_write(engine::LogLevel::Error, engine::LogCategory::cat, __VA_ARGS__)
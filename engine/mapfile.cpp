@@ -0,0 +1,135 @@
+#include "mapfile.h"
+#include "log.h"
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+
+// Slack after the tile grid, for 4-byte gathers of the last tile
+static const uint64_t TILE_SLACK = 3;
+
+static uint64_t align64(uint64_t v) { return (v + 63) & ~(uint64_t)63; }
+
+static uint64_t tile_bytes(uint64_t w, uint64_t h) { return (w + 2) * (h + 2); }
+static uint64_t solid_bytes(uint64_t w, uint64_t h) { return (h + 2) * ((w + 2 + 63) / 64) * 8; }
+
+static bool validate(const MapFile& f) {
+    if (f.size < sizeof(MapFileHeader))
+        return false;
+    const MapFileHeader* hdr = (const MapFileHeader*)f.base;
+    if (memcmp(hdr->magic, MAP_MAGIC, 4) != 0 || hdr->version != MAP_VERSION || hdr->w == 0 || hdr->h == 0 ||
+        hdr->w > (1u << 20) || hdr->h > (1u << 20))
+        return false;
+    if (hdr->tiles_offset % 64 != 0 || hdr->solid_offset % 64 != 0 || hdr->tiles_offset < sizeof(MapFileHeader))
+        return false;
+    const uint64_t tiles_end = hdr->tiles_offset + tile_bytes(hdr->w, hdr->h) + TILE_SLACK;
+    return tiles_end <= hdr->solid_offset && hdr->solid_offset + solid_bytes(hdr->w, hdr->h) <= f.size;
+}
+
+bool map_file_open(const char* path, MapFile& out) {
+    map_file_close(out);
+#ifdef _WIN32
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        LOG_WARN(Assets, "Cannot open map %s", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.storage.resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(out.storage.data(), 1, size, f) == (size_t)size;
+    fclose(f);
+    if (!ok) {
+        LOG_WARN(Assets, "Cannot read map %s", path);
+        out.storage.clear();
+        return false;
+    }
+    out.base = out.storage.data();
+    out.size = out.storage.size();
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG_WARN(Assets, "Cannot open map %s", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        LOG_WARN(Assets, "Cannot read map %s", path);
+        return false;
+    }
+    // Private and writable: tile edits are copy-on-write pages of this process
+    void* p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        LOG_WARN(Assets, "Cannot map %s", path);
+        return false;
+    }
+    out.base = p;
+    out.size = st.st_size;
+#endif
+    if (!validate(out)) {
+        LOG_WARN(Assets, "Ignoring invalid map: %s", path);
+        map_file_close(out);
+        return false;
+    }
+    unsigned char* base = (unsigned char*)out.base;
+    out.header = (const MapFileHeader*)base;
+    out.tiles = (char*)(base + out.header->tiles_offset);
+    out.solid = (uint64_t*)(base + out.header->solid_offset);
+    return true;
+}
+
+void map_file_close(MapFile& file) {
+#ifdef _WIN32
+    file.storage.clear();
+#else
+    if (file.base)
+        munmap(file.base, file.size);
+#endif
+    file.header = nullptr;
+    file.tiles = nullptr;
+    file.solid = nullptr;
+    file.base = nullptr;
+    file.size = 0;
+}
+
+bool map_file_write(const char* path, int w, int h, const char* tiles, const uint64_t* solid, int entrance_x,
+                    int entrance_y, int exit_x, int exit_y) {
+    MapFileHeader hdr = {};
+    memcpy(hdr.magic, MAP_MAGIC, 4);
+    hdr.version = MAP_VERSION;
+    hdr.w = w;
+    hdr.h = h;
+    hdr.entrance_x = entrance_x;
+    hdr.entrance_y = entrance_y;
+    hdr.exit_x = exit_x;
+    hdr.exit_y = exit_y;
+    hdr.tiles_offset = align64(sizeof(MapFileHeader));
+    hdr.solid_offset = align64(hdr.tiles_offset + tile_bytes(w, h) + TILE_SLACK);
+    const uint64_t size = hdr.solid_offset + solid_bytes(w, h);
+
+    std::vector<unsigned char> data(size, 0);
+    memcpy(data.data(), &hdr, sizeof(hdr));
+    memcpy(data.data() + hdr.tiles_offset, tiles, tile_bytes(w, h));
+    memcpy(data.data() + hdr.solid_offset, solid, solid_bytes(w, h));
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        LOG_ERROR(Assets, "Cannot write map %s", path);
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = fclose(f) == 0 && ok;
+    if (!ok)
+        LOG_ERROR(Assets, "Cannot write map %s", path);
+    return ok;
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+// Binary floor maps (.mvm): written by tools/tmx2mvm.cpp at build time and
+// memory-mapped at load time. The tiles are stored exactly as the level keeps
+// them (row-major, wall border, solidity mask alongside), so loading is a
+// mapping plus checks (the header here, the tiles by the level), with no
+// parsing and no copy.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    constexpr char MAP_MAGIC[4] = {'M', 'V', 'M', 'P'};
+    constexpr uint32_t MAP_VERSION = 1;
+
+    // File layout (little-endian): header, then the tiles and the solidity
+    // mask at 64-byte aligned offsets
+    struct MapFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t w, h;                     // map size, border not included
+        int32_t entrance_x, entrance_y;    // -1 when the map has none
+        int32_t exit_x, exit_y;
+        uint64_t tiles_offset;             // (w + 2) x (h + 2) tiles, border included,
+                                           // then at least 3 spare bytes
+        uint64_t solid_offset;             // (h + 2) rows of (w + 2 + 63) / 64 words
+        uint32_t reserved[4];
+    };
+    static_assert(sizeof(MapFileHeader) == 64, "MapFileHeader is part of the file format");
+
+    // A mapped .mvm. The mapping is private and writable: edits through
+    // tiles/solid stay in this process and never reach the file.
+    struct MapFile {
+        const MapFileHeader* header = nullptr;
+        char* tiles = nullptr;             // border tile (-1, -1)
+        uint64_t* solid = nullptr;
+        void* base = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        std::vector<unsigned char> storage; // no mmap: read it whole
+#endif
+    };
+
+    // Maps and validates path; false (with a warning) when it is missing or
+    // malformed
+    bool map_file_open(const char* path, MapFile& out);
+    void map_file_close(MapFile& file);
+
+    // Writes a map from storage in the same layout; tiles and solid cover the
+    // padded grid (see MapFileHeader)
+    bool map_file_write(const char* path, int w, int h, const char* tiles, const uint64_t* solid, int entrance_x,
+                        int entrance_y, int exit_x, int exit_y);
+}
@@ -0,0 +1,60 @@
+#pragma once
+// The SDL renderer calls the game makes, counted for the profiler: draw
+// calls and texture creations. Files that draw call these instead of the SDL
+// functions; without MORAVOR_PROFILE they are the plain SDL calls.
+#include "profiler.h"
+#include <SDL.h>
+
+namespace engine {
+    inline void prof_draw_call() {
+#ifdef MORAVOR_PROFILE
+        profile_count_draw_call();
+#endif
+    }
+    inline void prof_texture_created() {
+#ifdef MORAVOR_PROFILE
+        profile_count_texture_created();
+#endif
+    }
+
+    inline int prof_render_clear(SDL_Renderer* ren) {
+        prof_draw_call();
+        return SDL_RenderClear(ren);
+    }
+    inline int prof_render_copy(SDL_Renderer* ren, SDL_Texture* tex, const SDL_Rect* src, const SDL_Rect* dst) {
+        prof_draw_call();
+        return SDL_RenderCopy(ren, tex, src, dst);
+    }
+    inline int prof_render_fill_rect(SDL_Renderer* ren, const SDL_Rect* rect) {
+        prof_draw_call();
+        return SDL_RenderFillRect(ren, rect);
+    }
+    inline int prof_render_fill_rects(SDL_Renderer* ren, const SDL_Rect* rects, int count) {
+        prof_draw_call();
+        return SDL_RenderFillRects(ren, rects, count);
+    }
+    inline int prof_render_draw_rect(SDL_Renderer* ren, const SDL_Rect* rect) {
+        prof_draw_call();
+        return SDL_RenderDrawRect(ren, rect);
+    }
+    inline int prof_render_draw_line(SDL_Renderer* ren, int x1, int y1, int x2, int y2) {
+        prof_draw_call();
+        return SDL_RenderDrawLine(ren, x1, y1, x2, y2);
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    inline int prof_render_geometry(SDL_Renderer* ren, SDL_Texture* tex, const SDL_Vertex* vertices, int num_vertices,
+                                    const int* indices, int num_indices) {
+        prof_draw_call();
+        return SDL_RenderGeometry(ren, tex, vertices, num_vertices, indices, num_indices);
+    }
+#endif
+
+    inline SDL_Texture* prof_create_texture(SDL_Renderer* ren, Uint32 format, int access, int w, int h) {
+        prof_texture_created();
+        return SDL_CreateTexture(ren, format, access, w, h);
+    }
+    inline SDL_Texture* prof_create_texture_from_surface(SDL_Renderer* ren, SDL_Surface* surface) {
+        prof_texture_created();
+        return SDL_CreateTextureFromSurface(ren, surface);
+    }
+}
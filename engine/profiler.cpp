@@ -0,0 +1,200 @@
+#include "profiler.h"
+#include "log.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace engine {
+
+std::atomic<bool> g_profiler_enabled{false};
+std::atomic<uint32_t> g_profile_draw_calls{0};
+std::atomic<uint32_t> g_profile_textures_created{0};
+
+namespace {
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t begin_ns, end_ns;
+};
+
+// Single producer (the owning thread) / single consumer (the main thread in
+// profile_frame_end). A full ring drops new events rather than blocking.
+constexpr uint32_t RING_SIZE = 1 << 12;
+struct ThreadRing {
+    uint32_t tid = 0;
+    ProfileEvent events[RING_SIZE];
+    std::atomic<uint32_t> head{0}; // next write, owned by the producer
+    std::atomic<uint32_t> tail{0}; // next read, owned by the consumer
+    std::atomic<uint32_t> dropped{0};
+};
+
+struct TraceEvent {
+    const char* name;
+    uint64_t begin_ns, end_ns;
+    uint32_t tid;
+};
+struct TraceCounter {
+    uint64_t ns;
+    uint32_t draw_calls, textures_created;
+};
+
+// Rings live until exit: a thread's ring outlives the thread
+std::mutex g_rings_mutex;
+std::vector<std::unique_ptr<ThreadRing>> g_rings;
+thread_local ThreadRing* t_ring = nullptr;
+
+const auto g_epoch = std::chrono::steady_clock::now();
+
+// Trace history for export, oldest events overwritten first
+constexpr size_t MAX_TRACE_EVENTS = 1 << 18, MAX_TRACE_FRAMES = 1 << 14;
+std::vector<TraceEvent> g_trace;
+size_t g_trace_next = 0;
+std::vector<TraceCounter> g_counters;
+size_t g_counters_next = 0;
+
+ProfileFrames g_frames;
+uint64_t g_last_frame_ns = 0;
+
+ThreadRing* thread_ring() {
+    if (!t_ring) {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        g_rings.push_back(std::make_unique<ThreadRing>());
+        t_ring = g_rings.back().get();
+        t_ring->tid = (uint32_t)g_rings.size();
+    }
+    return t_ring;
+}
+
+template <typename T>
+void push_capped(std::vector<T>& v, size_t& next, size_t cap, const T& item) {
+    if (v.size() < cap) {
+        v.push_back(item);
+    } else {
+        v[next] = item;
+        next = (next + 1) % cap;
+    }
+}
+
+} // namespace
+
+void profiler_set_enabled(bool enabled) {
+    g_profiler_enabled.store(enabled, std::memory_order_relaxed);
+    g_last_frame_ns = 0;
+}
+
+uint64_t profile_now_ns() {
+    // +1 keeps 0 free to mean "not recording" in ProfileZone
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch)
+               .count() + 1;
+}
+
+void profile_record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+    ThreadRing* r = thread_ring();
+    uint32_t head = r->head.load(std::memory_order_relaxed);
+    if (head - r->tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        r->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    r->events[head % RING_SIZE] = {name, begin_ns, end_ns};
+    r->head.store(head + 1, std::memory_order_release);
+}
+
+void profile_frame_end() {
+    if (!profiler_enabled())
+        return;
+    const uint64_t now = profile_now_ns();
+    const uint32_t main_tid = thread_ring()->tid;
+    for (ProfileStage& s : g_frames.stages)
+        s.ms = 0.0f;
+    std::vector<ThreadRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        for (auto& r : g_rings)
+            rings.push_back(r.get());
+    }
+    uint32_t dropped = 0;
+    for (ThreadRing* r : rings) {
+        uint32_t tail = r->tail.load(std::memory_order_relaxed);
+        const uint32_t head = r->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            const ProfileEvent& e = r->events[tail % RING_SIZE];
+            push_capped(g_trace, g_trace_next, MAX_TRACE_EVENTS, TraceEvent{e.name, e.begin_ns, e.end_ns, r->tid});
+            if (r->tid != main_tid)
+                continue;
+            float ms = (e.end_ns - e.begin_ns) * 1e-6f;
+            bool found = false;
+            for (ProfileStage& s : g_frames.stages)
+                if (s.name == e.name) {
+                    s.ms += ms;
+                    found = true;
+                    break;
+                }
+            if (!found)
+                g_frames.stages.push_back({e.name, ms});
+        }
+        r->tail.store(tail, std::memory_order_release);
+        dropped += r->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    g_frames.draw_calls = g_profile_draw_calls.exchange(0, std::memory_order_relaxed);
+    g_frames.textures_created = g_profile_textures_created.exchange(0, std::memory_order_relaxed);
+    g_frames.dropped_events += dropped;
+    push_capped(g_counters, g_counters_next, MAX_TRACE_FRAMES,
+                TraceCounter{now, g_frames.draw_calls, g_frames.textures_created});
+    if (g_last_frame_ns) {
+        int slot = (g_frames.head + g_frames.count) % PROFILE_HISTORY;
+        g_frames.frame_ms[slot] = (now - g_last_frame_ns) * 1e-6f;
+        if (g_frames.count < PROFILE_HISTORY)
+            ++g_frames.count;
+        else
+            g_frames.head = (g_frames.head + 1) % PROFILE_HISTORY;
+    }
+    g_last_frame_ns = now;
+}
+
+const ProfileFrames& profiler_frames() { return g_frames; }
+
+static void write_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+bool profiler_write_chrome_trace(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        LOG_ERROR(Profiler, "Cannot write trace: %s", path);
+        return false;
+    }
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    // Oldest first; timestamps are microseconds
+    for (size_t i = 0; i < g_trace.size(); ++i) {
+        const TraceEvent& e = g_trace[(g_trace_next + i) % g_trace.size()];
+        fprintf(f, "%s{\"name\": ", first ? "" : ",\n");
+        write_json_string(f, e.name);
+        fprintf(f, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}", e.tid,
+                e.begin_ns * 1e-3, (e.end_ns - e.begin_ns) * 1e-3);
+        first = false;
+    }
+    for (size_t i = 0; i < g_counters.size(); ++i) {
+        const TraceCounter& c = g_counters[(g_counters_next + i) % g_counters.size()];
+        fprintf(f,
+                "%s{\"name\": \"renderer\", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, "
+                "\"args\": {\"draw_calls\": %u, \"textures_created\": %u}}",
+                first ? "" : ",\n", c.ns * 1e-3, c.draw_calls, c.textures_created);
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = fclose(f) == 0;
+    if (ok)
+        LOG_INFO(Profiler, "Wrote trace %s (%zu zones)", path, g_trace.size());
+    return ok;
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+// Frame profiler: named zones timed into per-thread lock-free rings, drained
+// once per frame into per-stage totals (for the overlay) and a trace history
+// (exported as Chrome trace_event JSON).
+//
+// Zones exist only when built with MORAVOR_PROFILE; even then they record
+// nothing until profiler_set_enabled(true), costing one relaxed load each.
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    extern std::atomic<bool> g_profiler_enabled;
+    extern std::atomic<uint32_t> g_profile_draw_calls;
+    extern std::atomic<uint32_t> g_profile_textures_created;
+
+    inline bool profiler_enabled() { return g_profiler_enabled.load(std::memory_order_relaxed); }
+    void profiler_set_enabled(bool enabled);
+
+    uint64_t profile_now_ns();
+    // Appends a finished zone to the calling thread's ring (name must be a
+    // string literal: only the pointer is stored)
+    void profile_record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+
+    class ProfileZone {
+    public:
+        explicit ProfileZone(const char* name) : name_(name), begin_(profiler_enabled() ? profile_now_ns() : 0) {}
+        ~ProfileZone() { end(); }
+        void end() {
+            if (begin_) {
+                profile_record(name_, begin_, profile_now_ns());
+                begin_ = 0;
+            }
+        }
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* name_;
+        uint64_t begin_;
+    };
+
+    inline void profile_count_draw_call() {
+        if (profiler_enabled())
+            g_profile_draw_calls.fetch_add(1, std::memory_order_relaxed);
+    }
+    inline void profile_count_texture_created() {
+        if (profiler_enabled())
+            g_profile_textures_created.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Closes the frame on the main thread: drains every ring, totals the main
+    // thread's zones per name and resets the per-frame counters
+    void profile_frame_end();
+
+    constexpr int PROFILE_HISTORY = 240; // frames kept for the graph
+
+    struct ProfileStage {
+        const char* name;
+        float ms; // main thread time in the last frame
+    };
+
+    struct ProfileFrames {
+        float frame_ms[PROFILE_HISTORY]; // ring, newest at (head + PROFILE_HISTORY - 1) % PROFILE_HISTORY
+        int head = 0, count = 0;
+        std::vector<ProfileStage> stages; // in order of first appearance
+        uint32_t draw_calls = 0, textures_created = 0, dropped_events = 0;
+    };
+    const ProfileFrames& profiler_frames();
+
+    // Writes the recorded zones (plus per-frame counters) as Chrome
+    // trace_event JSON, viewable in chrome://tracing or Perfetto
+    bool profiler_write_chrome_trace(const char* path);
+}
+
+#ifdef MORAVOR_PROFILE
+#define MORAVOR_PROFILE_CONCAT2(a, b) a##b
+#define MORAVOR_PROFILE_CONCAT(a, b) MORAVOR_PROFILE_CONCAT2(a, b)
+// Times the rest of the enclosing scope
+#define PROFILE_ZONE(name) engine::ProfileZone MORAVOR_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+// Explicitly closed zone, for spans that are not a scope
+#define PROFILE_BEGIN(id, name) engine::ProfileZone id(name)
+#define PROFILE_END(id) id.end()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_BEGIN(id, name) ((void)0)
+#define PROFILE_END(id) ((void)0)
+#endif
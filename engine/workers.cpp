@@ -0,0 +1,127 @@
+#include "workers.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+namespace {
+struct Job {
+    const std::function<void(int, int)>* fn = nullptr;
+    int begin = 0, end = 0, strip = 1, strips = 0;
+};
+
+std::vector<std::thread> g_threads;
+std::mutex g_mutex;
+std::condition_variable g_wake, g_done;
+Job g_job;
+unsigned g_generation = 0;    // bumped for every job, guarded by g_mutex
+int g_active = 0;             // workers holding a copy of g_job, guarded by g_mutex
+bool g_stop = false;
+std::atomic<int> g_next_strip{0};
+std::atomic<int> g_strips_left{0};
+
+// Takes strips until none are left; returns after the one that finished the job
+void run_strips(const Job& job) {
+    for (;;) {
+        int s = g_next_strip.fetch_add(1, std::memory_order_relaxed);
+        if (s >= job.strips)
+            return;
+        int a = job.begin + s * job.strip;
+        int b = std::min(job.end, a + job.strip);
+        {
+            PROFILE_ZONE("parallel strip");
+            (*job.fn)(a, b);
+        }
+        if (g_strips_left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_done.notify_one();
+        }
+    }
+}
+
+void worker_main() {
+    unsigned seen = 0;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(g_mutex);
+            g_wake.wait(lock, [&] { return g_stop || g_generation != seen; });
+            if (g_stop)
+                return;
+            seen = g_generation;
+            job = g_job;
+            ++g_active;
+        }
+        run_strips(job);
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (--g_active == 0)
+            g_done.notify_one();
+    }
+}
+} // namespace
+
+void workers_init(int thread_count) {
+    workers_shutdown();
+    if (thread_count <= 0)
+        thread_count = (int)std::max(1u, std::thread::hardware_concurrency());
+    g_stop = false;
+    for (int i = 1; i < thread_count; ++i)
+        g_threads.emplace_back(worker_main);
+}
+
+void workers_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_stop = true;
+    }
+    g_wake.notify_all();
+    for (auto& t : g_threads)
+        t.join();
+    g_threads.clear();
+}
+
+int workers_thread_count() { return (int)g_threads.size() + 1; }
+
+void parallel_for(int begin, int end, int align, const std::function<void(int, int)>& fn) {
+    if (end <= begin)
+        return;
+    int threads = workers_thread_count();
+    if (threads == 1) {
+        fn(begin, end);
+        return;
+    }
+    // A few strips per thread so uneven columns still balance out
+    if (align < 1)
+        align = 1;
+    int strips = threads * 4;
+    int strip = (end - begin + strips - 1) / strips;
+    strip = (strip + align - 1) / align * align;
+    Job job;
+    job.fn = &fn;
+    job.begin = begin;
+    job.end = end;
+    job.strip = strip;
+    job.strips = (end - begin + strip - 1) / strip;
+    {
+        // Counters are only reset once no worker can still be claiming
+        // strips of the previous job
+        std::unique_lock<std::mutex> lock(g_mutex);
+        g_done.wait(lock, [] { return g_active == 0; });
+        g_next_strip.store(0, std::memory_order_relaxed);
+        g_strips_left.store(job.strips, std::memory_order_relaxed);
+        g_job = job;
+        ++g_generation;
+    }
+    g_wake.notify_all();
+    run_strips(job);
+    // Barrier: wait for strips still running on workers
+    std::unique_lock<std::mutex> lock(g_mutex);
+    g_done.wait(lock, [] { return g_strips_left.load(std::memory_order_acquire) == 0; });
+}
+
+}
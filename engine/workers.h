@@ -0,0 +1,16 @@
+#pragma once
+// Persistent worker pool for data-parallel frame work
+#include <functional>
+
+namespace engine {
+    // Starts thread_count - 1 workers; the calling thread is the last one.
+    // thread_count <= 0 picks the hardware concurrency, 1 runs everything inline.
+    void workers_init(int thread_count);
+    void workers_shutdown();
+    int workers_thread_count();
+
+    // Splits [begin, end) into strips whose boundaries are multiples of align
+    // and runs fn(strip_begin, strip_end) on every thread, including the
+    // caller. Returns once all strips have finished (a barrier).
+    void parallel_for(int begin, int end, int align, const std::function<void(int, int)>& fn);
+}
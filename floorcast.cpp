@@ -0,0 +1,121 @@
+#include "floorcast.h"
+#include <cmath>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Texture coordinates are 16.16 fixed point in texel units. With
+// power-of-two textures, wrapping is a mask and the coordinate may
+// overflow freely, since 2^32 is a multiple of the texture size. Rows are
+// 1 << tex_shift_pitch texels apart, so the texel index is still shift + or.
+static void plane_span_pow2(Uint32* dst, int n, uint32_t u, uint32_t v, int32_t du, int32_t dv,
+                            const Uint32* tex, int tex_shift_w, int tex_shift_h, int tex_shift_pitch,
+                            bool shade) {
+    const uint32_t mask_u = (1u << tex_shift_w) - 1, mask_v = (1u << tex_shift_h) - 1;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i vmask_u = _mm_set1_epi32((int)mask_u), vmask_v = _mm_set1_epi32((int)mask_v);
+    const __m128i shade_mask = _mm_set1_epi32(0x007F7F7F), alpha = _mm_set1_epi32((int)0xFF000000);
+#if defined(__AVX2__)
+    const __m256i wmask_u = _mm256_set1_epi32((int)mask_u), wmask_v = _mm256_set1_epi32((int)mask_v);
+    const __m256i wshade_mask = _mm256_set1_epi32(0x007F7F7F), walpha = _mm256_set1_epi32((int)0xFF000000);
+    __m256i wu = _mm256_add_epi32(_mm256_set1_epi32((int)u),
+                                  _mm256_mullo_epi32(_mm256_set1_epi32(du), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256i wv = _mm256_add_epi32(_mm256_set1_epi32((int)v),
+                                  _mm256_mullo_epi32(_mm256_set1_epi32(dv), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m256i wdu8 = _mm256_set1_epi32((int)((uint32_t)du * 8)), wdv8 = _mm256_set1_epi32((int)((uint32_t)dv * 8));
+    for (; i + 8 <= n; i += 8) {
+        __m256i tx = _mm256_and_si256(_mm256_srli_epi32(wu, 16), wmask_u);
+        __m256i ty = _mm256_and_si256(_mm256_srli_epi32(wv, 16), wmask_v);
+        __m256i idx = _mm256_or_si256(_mm256_sll_epi32(ty, _mm_cvtsi32_si128(tex_shift_pitch)), tx);
+        __m256i px = _mm256_i32gather_epi32((const int*)tex, idx, 4);
+        if (shade)
+            px = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(px, 1), wshade_mask), walpha);
+        _mm256_storeu_si256((__m256i*)(dst + i), px);
+        wu = _mm256_add_epi32(wu, wdu8);
+        wv = _mm256_add_epi32(wv, wdv8);
+    }
+    u += (uint32_t)du * i;
+    v += (uint32_t)dv * i;
+#endif
+    // 4 texels per step; SSE2 has no gather, so the loads are per lane
+    __m128i vu = _mm_add_epi32(_mm_set1_epi32((int)u), _mm_setr_epi32(0, du, (int)((uint32_t)du * 2), (int)((uint32_t)du * 3)));
+    __m128i vv = _mm_add_epi32(_mm_set1_epi32((int)v), _mm_setr_epi32(0, dv, (int)((uint32_t)dv * 2), (int)((uint32_t)dv * 3)));
+    const __m128i du4 = _mm_set1_epi32((int)((uint32_t)du * 4)), dv4 = _mm_set1_epi32((int)((uint32_t)dv * 4));
+    alignas(16) uint32_t idx[4];
+    for (; i + 4 <= n; i += 4) {
+        __m128i tx = _mm_and_si128(_mm_srli_epi32(vu, 16), vmask_u);
+        __m128i ty = _mm_and_si128(_mm_srli_epi32(vv, 16), vmask_v);
+        _mm_store_si128((__m128i*)idx, _mm_or_si128(_mm_sll_epi32(ty, _mm_cvtsi32_si128(tex_shift_pitch)), tx));
+        __m128i px = _mm_setr_epi32((int)tex[idx[0]], (int)tex[idx[1]], (int)tex[idx[2]], (int)tex[idx[3]]);
+        if (shade)
+            px = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(px, 1), shade_mask), alpha);
+        _mm_storeu_si128((__m128i*)(dst + i), px);
+        vu = _mm_add_epi32(vu, du4);
+        vv = _mm_add_epi32(vv, dv4);
+    }
+    u = (uint32_t)_mm_cvtsi128_si32(vu);
+    v = (uint32_t)_mm_cvtsi128_si32(vv);
+#endif
+    for (; i < n; ++i) {
+        uint32_t px = tex[(((v >> 16) & mask_v) << tex_shift_pitch) | ((u >> 16) & mask_u)];
+        dst[i] = shade ? ((px >> 1) & 0x007F7F7F) | 0xFF000000 : px;
+        u += du;
+        v += dv;
+    }
+}
+
+// Any texture size: float coordinates wrapped with floorf
+static void plane_span_generic(Uint32* dst, int n, float fx, float fy, float sx, float sy,
+                               const Uint32* tex, int tex_w, int tex_h, int tex_pitch, bool shade) {
+    for (int i = 0; i < n; ++i, fx += sx, fy += sy) {
+        int tx = (int)((fx - floorf(fx)) * tex_w);
+        int ty = (int)((fy - floorf(fy)) * tex_h);
+        if (tx >= tex_w)
+            tx = tex_w - 1;
+        if (ty >= tex_h)
+            ty = tex_h - 1;
+        uint32_t px = tex[(size_t)ty * tex_pitch + tx];
+        dst[i] = shade ? ((px >> 1) & 0x007F7F7F) | 0xFF000000 : px;
+    }
+}
+
+static int log2_exact(int v) {
+    if (v <= 0 || (v & (v - 1)))
+        return -1;
+    int s = 0;
+    while ((1 << s) < v)
+        ++s;
+    return s;
+}
+
+void cast_plane_rows(const Camera& cam, Uint32* pixels, int w, int h, int y0, int y1,
+                     const Uint32* tex, int tex_w, int tex_h, int tex_pitch) {
+    const int horizon = h / 2;
+    const float pos_z = 0.5f * h; // camera height matching the wall projection
+    const float ray0_x = cam.dir_x - cam.plane_x, ray0_y = cam.dir_y - cam.plane_y;
+    const float ray1_x = cam.dir_x + cam.plane_x, ray1_y = cam.dir_y + cam.plane_y;
+    const int shift_w = log2_exact(tex_w), shift_h = log2_exact(tex_h), shift_p = log2_exact(tex_pitch);
+    const bool pow2 = shift_w >= 0 && shift_h >= 0 && shift_p >= 0 && shift_w <= 15 && shift_h <= 15;
+    for (int y = y0; y < y1; ++y) {
+        bool ceiling = y < horizon;
+        // Distance to the floor (or ceiling) seen through this row's centers
+        float p = ceiling ? horizon - y - 0.5f : y - horizon + 0.5f;
+        float row_dist = pos_z / p;
+        float step_x = row_dist * (ray1_x - ray0_x) / w;
+        float step_y = row_dist * (ray1_y - ray0_y) / w;
+        float floor_x = cam.pos_x + row_dist * ray0_x + 0.5f * step_x;
+        float floor_y = cam.pos_y + row_dist * ray0_y + 0.5f * step_y;
+        Uint32* row = pixels + (size_t)y * w;
+        if (pow2) {
+            float fu = (floor_x - floorf(floor_x)) * tex_w * 65536.0f;
+            float fv = (floor_y - floorf(floor_y)) * tex_h * 65536.0f;
+            plane_span_pow2(row, w, (uint32_t)(int64_t)fu, (uint32_t)(int64_t)fv,
+                            (int32_t)lrintf(step_x * tex_w * 65536.0f), (int32_t)lrintf(step_y * tex_h * 65536.0f),
+                            tex, shift_w, shift_h, shift_p, ceiling);
+        } else {
+            plane_span_generic(row, w, floor_x, floor_y, step_x, step_y, tex, tex_w, tex_h, tex_pitch, ceiling);
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "raycast.h"
+#include <SDL.h>
+
+// Floor and ceiling casting: every row below the horizon (rows above it,
+// mirrored, for the ceiling) samples the floor texture with perspective-
+// correct coordinates. Rows are written by a SIMD span kernel.
+
+// Casts rows [y0, y1) of a w x h ARGB8888 view (pitch = w). The ceiling is
+// the floor texture at half brightness. tex must be tex_w x tex_h ARGB8888
+// with rows tex_pitch pixels apart.
+void cast_plane_rows(const Camera& cam, Uint32* pixels, int w, int h, int y0, int y1,
+                     const Uint32* tex, int tex_w, int tex_h, int tex_pitch);
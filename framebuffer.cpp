@@ -0,0 +1,40 @@
+#include "framebuffer.h"
+#include "engine/profile_sdl.h"
+#include "engine/log.h"
+
+bool framebuffer_resize(Framebuffer& fb, SDL_Renderer* ren, int w, int h) {
+    if (fb.tex && fb.w == w && fb.h == h)
+        return true;
+    framebuffer_free(fb);
+    if (w <= 0 || h <= 0)
+        return false;
+    fb.tex = engine::prof_create_texture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+    if (!fb.tex) {
+        LOG_ERROR(Render, "SDL_CreateTexture failed for framebuffer: %s", SDL_GetError());
+        return false;
+    }
+    fb.w = w;
+    fb.h = h;
+    fb.pixels.assign((size_t)w * h, 0xFF000000);
+    return true;
+}
+
+void framebuffer_upload(Framebuffer& fb) {
+    if (fb.tex)
+        SDL_UpdateTexture(fb.tex, nullptr, fb.pixels.data(), fb.w * (int)sizeof(Uint32));
+}
+
+void framebuffer_present(Framebuffer& fb, SDL_Renderer* ren, const SDL_Rect* dst) {
+    if (!fb.tex)
+        return;
+    framebuffer_upload(fb);
+    engine::prof_render_copy(ren, fb.tex, nullptr, dst);
+}
+
+void framebuffer_free(Framebuffer& fb) {
+    if (fb.tex)
+        SDL_DestroyTexture(fb.tex);
+    fb.tex = nullptr;
+    fb.w = fb.h = 0;
+    fb.pixels.clear();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+// CPU pixels of an image (ARGB8888), either owned or borrowed from the
+// mapped asset pack; rows are pitch pixels apart
+struct PixelImage {
+    int w = 0, h = 0;
+    int pitch = 0;
+    const Uint32* px = nullptr;
+    std::vector<Uint32> storage; // backs px when the image owns its pixels
+
+    PixelImage() = default;
+    PixelImage(PixelImage&&) = default;
+    PixelImage& operator=(PixelImage&&) = default;
+    PixelImage(const PixelImage&) = delete;
+    PixelImage& operator=(const PixelImage&) = delete;
+};
+
+// CPU-side ARGB8888 pixel buffer backed by one streaming texture
+struct Framebuffer {
+    int w = 0, h = 0;
+    std::vector<Uint32> pixels; // row-major, pitch = w
+    SDL_Texture* tex = nullptr;
+};
+
+// (Re)allocates pixels and the streaming texture when the size changes
+bool framebuffer_resize(Framebuffer& fb, SDL_Renderer* ren, int w, int h);
+
+// Uploads the pixels with one texture update
+void framebuffer_upload(Framebuffer& fb);
+
+// Uploads the pixels with one texture update and copies them to dst
+void framebuffer_present(Framebuffer& fb, SDL_Renderer* ren, const SDL_Rect* dst);
+
+void framebuffer_free(Framebuffer& fb);
@@ -1,4 +1,158 @@
-// Entities logic (stub)
+#include "entities.h"
+#include "level.h"
+#include "engine/log.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
 namespace game {
-    void update_entities();
+
+void entities_reset(FloorEntities& ents, int w, int h) {
+    ents.w = w;
+    ents.h = h;
+    ents.monsters.clear();
+    ents.next.clear();
+    ents.at.assign((size_t)w * h, NO_ENTITY);
+}
+
+static void unlink(FloorEntities& ents, EntityId id) {
+    const Monster& m = ents.monsters[id];
+    EntityId* link = &ents.at[(size_t)m.y * ents.w + m.x];
+    while (*link != id)
+        link = &ents.next[*link];
+    *link = ents.next[id];
+}
+
+static void link(FloorEntities& ents, EntityId id) {
+    const Monster& m = ents.monsters[id];
+    EntityId& head = ents.at[(size_t)m.y * ents.w + m.x];
+    ents.next[id] = head;
+    head = id;
+}
+
+EntityId entities_add(FloorEntities& ents, const Monster& monster) {
+    assert(monster.x >= 0 && monster.x < ents.w && monster.y >= 0 && monster.y < ents.h);
+    const EntityId id = (EntityId)ents.monsters.size();
+    ents.monsters.push_back(monster);
+    ents.next.push_back(NO_ENTITY);
+    link(ents, id);
+    return id;
+}
+
+void entities_pack(FloorEntities& ents) {
+    ents.w = ents.h = 0;
+    ents.at = std::vector<EntityId>();
+    ents.next = std::vector<EntityId>();
+}
+
+void entities_unpack(FloorEntities& ents, int w, int h) {
+    if (ents.w == w && ents.h == h && ents.next.size() == ents.monsters.size())
+        return;
+    std::vector<Monster> monsters = std::move(ents.monsters);
+    entities_reset(ents, w, h);
+    for (const Monster& m : monsters)
+        entities_add(ents, m);
+}
+
+static bool same_monster(const Monster& a, const Monster& b) {
+    return a.x == b.x && a.y == b.y && a.dir == b.dir && a.state == b.state && a.agility == b.agility;
+}
+
+void entities_drop(FloorEntities& ents, const std::vector<Monster>& spawn, EntityDelta& delta) {
+    delta.changed.clear();
+    for (size_t i = 0; i < ents.monsters.size(); ++i)
+        if (i >= spawn.size() || !same_monster(ents.monsters[i], spawn[i]))
+            delta.changed.emplace_back((EntityId)i, ents.monsters[i]);
+    delta.changed.shrink_to_fit();
+    entities_pack(ents);
+    ents.monsters = std::vector<Monster>();
+}
+
+void entities_restore(FloorEntities& ents, const std::vector<Monster>& spawn, const EntityDelta& delta, int w, int h) {
+    std::vector<Monster> monsters = spawn;
+    for (const auto& c : delta.changed) {
+        if ((size_t)c.first >= monsters.size())
+            monsters.resize(c.first + 1, c.second);
+        monsters[c.first] = c.second;
+    }
+    entities_reset(ents, w, h);
+    for (const Monster& m : monsters)
+        entities_add(ents, m);
+}
+
+void entities_move(FloorEntities& ents, EntityId id, int x, int y) {
+    assert(x >= 0 && x < ents.w && y >= 0 && y < ents.h);
+    unlink(ents, id);
+    ents.monsters[id].x = x;
+    ents.monsters[id].y = y;
+    link(ents, id);
+}
+
+void entities_in_radius(const FloorEntities& ents, int x, int y, int radius, std::vector<EntityId>& out) {
+    const int y0 = std::max(0, y - radius), y1 = std::min(ents.h - 1, y + radius);
+    const int x0 = std::max(0, x - radius), x1 = std::min(ents.w - 1, x + radius);
+    for (int ty = y0; ty <= y1; ++ty) {
+        const EntityId* row = &ents.at[(size_t)ty * ents.w];
+        for (int tx = x0; tx <= x1; ++tx) {
+            if (row[tx] == NO_ENTITY || (tx - x) * (tx - x) + (ty - y) * (ty - y) > radius * radius)
+                continue;
+            for (EntityId id = row[tx]; id != NO_ENTITY; id = ents.next[id])
+                out.push_back(id);
+        }
+    }
+}
+
+std::pair<int,int> find_monster_spawn(const std::vector<std::string>& map, int px, int py, int ex, int ey) {
+    // Try to find a walkable tile not at player or exit
+    for (int y = 1; y < (int)map.size()-1; ++y) {
+        for (int x = 1; x < (int)map[0].size()-1; ++x) {
+            if (map[y][x] == '.' && !(x == px && y == py) && !(x == ex && y == ey)) {
+                return std::make_pair(x, y);
+            }
+        }
+    }
+    // Fallback: try to find any walkable tile
+    for (int y = 1; y < (int)map.size()-1; ++y) {
+        for (int x = 1; x < (int)map[0].size()-1; ++x) {
+            if (map[y][x] == '.') {
+                return std::make_pair(x, y);
+            }
+        }
+    }
+    // As a last resort, return (1,1)
+    return std::make_pair(1, 1);
+}
+
+void monster_act(FloorEntities& ents, EntityId id) {
+    Monster& monster = ents.monsters[id];
+    const char* action;
+    if (monster.state == MonsterState::Idle) {
+        if (rand() % 2 == 0) {
+            // Turn: random direction
+            monster.dir = rand() % 4;
+            action = "Turned";
+        } else {
+            // Walk: move forward if possible
+            static const int dx[4] = {0, 1, 0, -1};
+            static const int dy[4] = {-1, 0, 1, 0};
+            int nx = monster.x + dx[monster.dir];
+            int ny = monster.y + dy[monster.dir];
+            if (is_walkable(get_tile_unchecked(nx, ny)) && entity_at(ents, nx, ny) == NO_ENTITY) {
+                entities_move(ents, id, nx, ny);
+                action = "Walked";
+            } else {
+                action = "Idle (blocked)";
+            }
+        }
+    } else if (monster.state == MonsterState::Dead) {
+        action = "Dead";
+    } else {
+        action = "Unknown";
+    }
+    LOG_DEBUG(Game, "Monster: state=%s, pos=(%d,%d), dir=%c, action=%s",
+              monster.state == MonsterState::Idle ? "Idle" : (monster.state == MonsterState::Agro ? "Agro" : "Dead"),
+              monster.x, monster.y, "NESW"[monster.dir % 4], action);
+    (void)action; // only read by the debug log
+}
+
 }
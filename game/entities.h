@@ -0,0 +1,66 @@
+#pragma once
+// Monsters and where they stand. A floor's entities are indexed by an
+// occupancy grid kept beside the level, never in its tiles: one entity id per
+// tile, with any others on the same tile chained behind it.
+#include "player.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace game {
+    using EntityId = int32_t; // index into FloorEntities::monsters
+    constexpr EntityId NO_ENTITY = -1;
+
+    struct FloorEntities {
+        int w = 0, h = 0;
+        std::vector<Monster> monsters;
+        std::vector<EntityId> at;   // per tile, row-major: first entity there
+        std::vector<EntityId> next; // per entity: the next one on its tile
+    };
+
+    // Empties the set for a w x h floor
+    void entities_reset(FloorEntities& ents, int w, int h);
+    // Adds a monster where it stands and returns its id
+    EntityId entities_add(FloorEntities& ents, const Monster& monster);
+    // Drops the occupancy grid of a floor nobody is on, keeping only its
+    // monsters; lookups find nothing until entities_unpack() indexes them
+    // again for a w x h floor (ids don't change)
+    void entities_pack(FloorEntities& ents);
+    void entities_unpack(FloorEntities& ents, int w, int h);
+
+    // A floor's monsters while its tiles are dropped (level.h): only the
+    // ones that differ from what the floor spawns with, by id, so the rest
+    // come back from its seed. Ids past the spawn are monsters added since.
+    struct EntityDelta {
+        std::vector<std::pair<EntityId, Monster>> changed;
+    };
+    // Empties ents, keeping in delta how its monsters differ from spawn
+    void entities_drop(FloorEntities& ents, const std::vector<Monster>& spawn, EntityDelta& delta);
+    // Refills ents for a w x h floor: the spawn with delta applied
+    void entities_restore(FloorEntities& ents, const std::vector<Monster>& spawn, const EntityDelta& delta, int w, int h);
+    // Moves an entity to (x, y), which must be on the floor
+    void entities_move(FloorEntities& ents, EntityId id, int x, int y);
+
+    // An entity at (x, y), or NO_ENTITY (also off the floor). The others on
+    // that tile follow through entities_next().
+    inline EntityId entity_at(const FloorEntities& ents, int x, int y) {
+        if ((unsigned)x >= (unsigned)ents.w || (unsigned)y >= (unsigned)ents.h)
+            return NO_ENTITY;
+        return ents.at[(size_t)y * ents.w + x];
+    }
+    inline EntityId entities_next(const FloorEntities& ents, EntityId id) { return ents.next[id]; }
+
+    // Appends every entity within radius tiles of (x, y) (Euclidean) to out,
+    // nearest rows first; scans the (2 * radius + 1)^2 tiles around it
+    void entities_in_radius(const FloorEntities& ents, int x, int y, int radius, std::vector<EntityId>& out);
+
+    // A floor tile for a new monster: the first one (row-major) that isn't at
+    // (px, py) or (ex, ey)
+    std::pair<int,int> find_monster_spawn(const std::vector<std::string>& map, int px, int py, int ex, int ey);
+
+    // One monster action (idle: a random turn or a step forward onto a
+    // walkable tile nobody stands on). Only the occupancy grid changes; the
+    // level's tiles are left alone.
+    void monster_act(FloorEntities& ents, EntityId id);
+}
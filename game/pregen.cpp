@@ -0,0 +1,142 @@
+#include "pregen.h"
+#include "entities.h"
+#include "random_floor.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace game {
+
+namespace {
+struct Request {
+    int index = -1, w = 0, h = 0;
+    unsigned seed = 0;
+};
+
+std::thread g_thread;
+std::mutex g_mutex;
+std::condition_variable g_wake;
+Request g_request;     // waiting to start; index -1 when none
+int g_building = -1;   // floor being built, -1 when idle
+FloorBuild g_done;     // last finished build; index -1 when none
+bool g_stop = false;
+// Read by the background thread too; only written before it starts
+std::vector<FloorStyle> g_styles = {FloorStyle::Maze, FloorStyle::Caves, FloorStyle::Halls};
+// The spawn of the floor rebuild_floor() last built; main thread only
+int g_rebuilt = -1;
+std::vector<Monster> g_rebuilt_spawn;
+
+// One monster on the first free floor tile
+std::vector<Monster> spawn_monsters(const std::vector<std::string>& map, std::pair<int,int> entrance, std::pair<int,int> exit) {
+    auto spawn = find_monster_spawn(map, entrance.first, entrance.second, exit.first, exit.second);
+    Monster m;
+    m.x = spawn.first;
+    m.y = spawn.second;
+    m.dir = 1;
+    m.state = MonsterState::Idle;
+    return {m};
+}
+
+void pregen_main() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    for (;;) {
+        g_wake.wait(lock, [] { return g_stop || g_request.index >= 0; });
+        if (g_stop)
+            return;
+        const Request req = g_request;
+        g_request.index = -1;
+        g_building = req.index;
+        lock.unlock();
+        FloorBuild build;
+        generate_floor(req.index, req.w, req.h, req.seed, build);
+        lock.lock();
+        g_building = -1;
+        g_done = std::move(build);
+    }
+}
+} // namespace
+
+unsigned floor_seed(unsigned run_seed, int index) {
+    // splitmix64 finalizer, so neighbouring floors get unrelated seeds
+    uint64_t z = ((uint64_t)run_seed << 32 | (uint32_t)index) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    const unsigned seed = (unsigned)(z ^ (z >> 31));
+    return seed ? seed : 1;
+}
+
+void set_floor_styles(std::vector<FloorStyle> styles) {
+    if (!styles.empty())
+        g_styles = std::move(styles);
+}
+
+FloorStyle floor_style(int index) {
+    return g_styles[(size_t)std::max(index - 1, 0) % g_styles.size()];
+}
+
+void generate_floor(int index, int w, int h, unsigned seed, FloorBuild& out) {
+    std::pair<int,int> entrance, exit;
+    std::vector<std::string> map = floor_generator(floor_style(index))(w, h, entrance, exit, seed, nullptr);
+    out.index = index;
+    out.seed = seed;
+    out.monsters = spawn_monsters(map, entrance, exit);
+    out.storage = make_floor(map, entrance, exit);
+}
+
+FloorPtr rebuild_floor(int index, unsigned seed, int w, int h) {
+    std::pair<int,int> entrance, exit;
+    std::vector<std::string> map = floor_generator(floor_style(index))(w, h, entrance, exit, seed, nullptr);
+    g_rebuilt = index;
+    g_rebuilt_spawn = spawn_monsters(map, entrance, exit);
+    return make_floor(map, entrance, exit);
+}
+
+bool take_rebuilt_spawn(int index, std::vector<Monster>& out) {
+    if (g_rebuilt != index)
+        return false;
+    out = std::move(g_rebuilt_spawn);
+    g_rebuilt = -1;
+    g_rebuilt_spawn = std::vector<Monster>();
+    return true;
+}
+
+void pregen_request(int index, int w, int h, unsigned seed) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_building == index || g_done.index == index)
+        return;
+    if (g_done.index >= 0)
+        g_done = FloorBuild();
+    g_request = {index, w, h, seed};
+    if (!g_thread.joinable()) {
+        g_stop = false;
+        g_thread = std::thread(pregen_main);
+    }
+    g_wake.notify_one();
+}
+
+bool pregen_take(int index, FloorBuild& out) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_request.index == index)
+        g_request.index = -1; // never started; the caller builds it now
+    if (g_done.index != index)
+        return false;
+    out = std::move(g_done);
+    g_done = FloorBuild();
+    return true;
+}
+
+void pregen_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_stop = true;
+        g_request.index = -1;
+    }
+    g_wake.notify_one();
+    if (g_thread.joinable())
+        g_thread.join();
+    g_done = FloorBuild();
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Builds the next floor on a background thread while the current one is
+// played, so taking the stairs only has to store the finished floor. One
+// floor is built at a time; requests come from the main thread.
+#include "level.h"
+#include "player.h"
+#include "random_floor.h"
+#include <vector>
+
+namespace game {
+    // A generated floor, ready for add_floor()
+    struct FloorBuild {
+        int index = -1;  // the floor it was built for
+        unsigned seed = 0;
+        FloorPtr storage; // tiles in level layout, entrance and exit included
+        std::vector<Monster> monsters; // what the floor spawns with
+    };
+
+    // The generator seed of floor index in a run started from run_seed; never 0
+    unsigned floor_seed(unsigned run_seed, int index);
+
+    // Floor styles by depth: floor index i (1 = the first generated) is built
+    // in styles[(i - 1) % styles.size()]; maze, caves, halls by default. Set
+    // before the first floor is generated, and not after, or floors rebuilt
+    // later won't match.
+    void set_floor_styles(std::vector<FloorStyle> styles);
+    FloorStyle floor_style(int index);
+
+    // Generates floor index (w x h) from seed and spawns its monster, on the
+    // calling thread
+    void generate_floor(int index, int w, int h, unsigned seed, FloorBuild& out);
+    // Generates the tiles again, for set_floor_rebuild(), and keeps the
+    // monsters they spawn for take_rebuilt_spawn() (main thread only)
+    FloorPtr rebuild_floor(int index, unsigned seed, int w, int h);
+    // What floor index spawns with, if rebuild_floor() last built it
+    bool take_rebuilt_spawn(int index, std::vector<Monster>& out);
+
+    // Starts building floor index in the background, unless it is already
+    // being built or finished. A finished build of another floor is dropped.
+    void pregen_request(int index, int w, int h, unsigned seed);
+    // Hands over floor index if its build has finished; false while it is
+    // still running (it finishes unused) or when it was never requested
+    bool pregen_take(int index, FloorBuild& out);
+    // Waits for a running build, then stops the thread
+    void pregen_shutdown();
+}
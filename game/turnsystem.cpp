@@ -1,4 +1,66 @@
-// Turn system logic (stub)
+#include "turnsystem.h"
+#include <algorithm>
+#include <queue>
+#include <vector>
+
 namespace game {
-    void process_turn();
+
+namespace {
+struct Pending {
+    uint64_t time;
+    uint64_t seq; // scheduling order, breaks ties
+    ActorId id;
+    bool operator>(const Pending& o) const { return time != o.time ? time > o.time : seq > o.seq; }
+};
+
+std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> g_queue;
+std::vector<int> g_agility; // per actor; 0 once removed
+uint64_t g_now = 0;
+uint64_t g_seq = 0;
+} // namespace
+
+int action_delay(int agility) {
+    return std::max(1, BASE_ACTION_DELAY * REFERENCE_AGILITY / std::max(1, agility));
+}
+
+void turns_reset() {
+    g_queue = {};
+    g_agility.clear();
+    g_now = 0;
+    g_seq = 0;
+}
+
+ActorId turns_add_actor(int agility) {
+    ActorId id = (ActorId)g_agility.size();
+    g_agility.push_back(std::max(1, agility));
+    g_queue.push({g_now + action_delay(agility), g_seq++, id});
+    return id;
+}
+
+void turns_remove_actor(ActorId id) {
+    if (id >= 0 && id < (ActorId)g_agility.size())
+        g_agility[id] = 0;
+}
+
+uint64_t turns_now() { return g_now; }
+
+void turns_advance(uint64_t until, const ActorFn& act) {
+    while (!g_queue.empty() && g_queue.top().time <= until) {
+        Pending p = g_queue.top();
+        g_queue.pop();
+        if (g_agility[p.id] == 0)
+            continue;
+        g_now = p.time;
+        act(p.id);
+        // act may have removed the actor
+        if (g_agility[p.id] != 0)
+            g_queue.push({p.time + action_delay(g_agility[p.id]), g_seq++, p.id});
+    }
+    g_now = std::max(g_now, until);
+}
+
+void process_turn(int player_agility, const ActorFn& act) {
+    turns_advance(g_now + action_delay(player_agility), act);
+}
+
 }
@@ -0,0 +1,34 @@
+#pragma once
+// Time-ordered turn scheduler. Actors wait in a min-heap keyed by the game
+// time of their next action; time only moves when the player acts (or on
+// fixed ticks), never per rendered frame.
+#include <cstdint>
+#include <functional>
+
+namespace game {
+    // An actor with REFERENCE_AGILITY acts every BASE_ACTION_DELAY time units;
+    // twice the agility acts twice as often
+    constexpr int BASE_ACTION_DELAY = 100;
+    constexpr int REFERENCE_AGILITY = 4;
+    int action_delay(int agility);
+
+    using ActorId = int;
+    using ActorFn = std::function<void(ActorId)>;
+
+    // Drops every actor; the clock restarts at 0
+    void turns_reset();
+    // Schedules an actor's first action one action delay from now
+    ActorId turns_add_actor(int agility);
+    // The actor's pending action is skipped (lazily, when it reaches the top)
+    void turns_remove_actor(ActorId id);
+    uint64_t turns_now();
+
+    // Runs every action due at or before until in time order (ties in the
+    // order they were scheduled), rescheduling each actor one delay later.
+    // O(log n) per action.
+    void turns_advance(uint64_t until, const ActorFn& act);
+
+    // The player took an action: everyone due before the player's next
+    // action acts
+    void process_turn(int player_agility, const ActorFn& act);
+}
@@ -0,0 +1,128 @@
+#include "random_floor.h"
+#include "level.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+namespace {
+
+const int MIN_PART = 8;  // smallest side of a partition
+const int MAX_PART = 20; // partitions with a longer side are always split
+
+// A rectangle of the floor's inside. Leaves hold a room; every node keeps a
+// floor tile (ax, ay) to run corridors from: its room's centre for leaves, one
+// of its children's for the rest.
+struct BspNode {
+    int x, y, w, h;
+    BspNode* child[2];
+    int ax, ay;
+};
+
+// Bump allocator: objects live in fixed blocks (never moved, so pointers to
+// them stay valid) and all go at once with the arena. They can also be
+// visited in allocation order.
+template <typename T>
+class Arena {
+public:
+    T* alloc() {
+        if (used_ == blocks_.size() * BLOCK)
+            blocks_.emplace_back(new T[BLOCK]);
+        T* t = &blocks_[used_ / BLOCK][used_ % BLOCK];
+        ++used_;
+        return t;
+    }
+    size_t size() const { return used_; }
+    T& operator[](size_t i) { return blocks_[i / BLOCK][i % BLOCK]; }
+
+private:
+    static const size_t BLOCK = 4096;
+    std::vector<std::unique_ptr<T[]>> blocks_;
+    size_t used_ = 0;
+};
+
+BspNode* new_node(Arena<BspNode>& arena, int x, int y, int w, int h) {
+    BspNode* n = arena.alloc();
+    *n = BspNode{x, y, w, h, {nullptr, nullptr}, 0, 0};
+    return n;
+}
+
+void carve(std::vector<std::string>& map, int x0, int y0, int x1, int y1) {
+    for (int y = std::min(y0, y1); y <= std::max(y0, y1); ++y)
+        for (int x = std::min(x0, x1); x <= std::max(x0, x1); ++x)
+            map[y][x] = TILE_FLOOR;
+}
+
+} // namespace
+
+std::vector<std::string> generate_hall_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed, FloorGenStats* stats) {
+    FloorRng rng(seed ? seed : std::random_device{}());
+    std::vector<std::string> map(h, std::string(w, TILE_WALL));
+
+    // 1. Split the inside of the walls. Children are allocated after their
+    // parent, so walking the arena in order visits every node once.
+    Arena<BspNode> nodes;
+    new_node(nodes, 1, 1, w - 2, h - 2);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        BspNode& n = nodes[i];
+        const bool across = n.w >= 2 * MIN_PART, down = n.h >= 2 * MIN_PART;
+        if (!across && !down)
+            continue;
+        if (n.w <= MAX_PART && n.h <= MAX_PART && rng() % 4 == 0)
+            continue;
+        // Cut the long side, or either when the node is about square
+        bool vertical = across;
+        if (across && down) {
+            if (n.w * 4 > n.h * 5)
+                vertical = true;
+            else if (n.h * 4 > n.w * 5)
+                vertical = false;
+            else
+                vertical = rng() % 2;
+        }
+        if (vertical) {
+            const int cut = MIN_PART + rng() % (n.w - 2 * MIN_PART + 1);
+            n.child[0] = new_node(nodes, n.x, n.y, cut, n.h);
+            n.child[1] = new_node(nodes, n.x + cut, n.y, n.w - cut, n.h);
+        } else {
+            const int cut = MIN_PART + rng() % (n.h - 2 * MIN_PART + 1);
+            n.child[0] = new_node(nodes, n.x, n.y, n.w, cut);
+            n.child[1] = new_node(nodes, n.x, n.y + cut, n.w, n.h - cut);
+        }
+    }
+
+    // 2. Rooms in the leaves, leaving the partition's last column and row as
+    // wall; then, children before parents, a corridor between each pair of
+    // siblings
+    int rooms = 0;
+    for (size_t i = nodes.size(); i-- > 0;) {
+        BspNode& n = nodes[i];
+        if (!n.child[0]) {
+            const int room_w = (n.w - 1) / 2 + rng() % (n.w - 1 - (n.w - 1) / 2 + 1);
+            const int room_h = (n.h - 1) / 2 + rng() % (n.h - 1 - (n.h - 1) / 2 + 1);
+            const int rx = n.x + rng() % (n.w - room_w), ry = n.y + rng() % (n.h - room_h);
+            carve(map, rx, ry, rx + room_w - 1, ry + room_h - 1);
+            n.ax = rx + room_w / 2;
+            n.ay = ry + room_h / 2;
+            ++rooms;
+            continue;
+        }
+        const BspNode& a = *n.child[0];
+        const BspNode& b = *n.child[1];
+        if (rng() % 2) {
+            carve(map, a.ax, a.ay, b.ax, a.ay);
+            carve(map, b.ax, a.ay, b.ax, b.ay);
+        } else {
+            carve(map, a.ax, a.ay, a.ax, b.ay);
+            carve(map, a.ax, b.ay, b.ax, b.ay);
+        }
+        const BspNode& via = *n.child[rng() % 2];
+        n.ax = via.ax;
+        n.ay = via.ay;
+    }
+
+    // 3. Doorways, joined to the rooms (which the corridors already link)
+    finish_floor(map, rng, entrance_pos, exit_pos, stats, true);
+    if (stats)
+        stats->rooms = rooms;
+    return map;
+}
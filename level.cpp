@@ -1,13 +1,24 @@
 #include "level.h"
+#include "engine/mapfile.h"
+#include "engine/log.h"
+#include <algorithm>
 #include <cstring>
 
 #include <vector>
 #include <string>
 #include <utility>
 #include <cassert>
+#include <memory>
+#include <unordered_map>
 
 int MAP_W = 16, MAP_H = 14;
-std::vector<std::string> level_data = {
+const char* level_tiles = nullptr;
+int level_stride = 0;
+const uint64_t* level_solid = nullptr;
+int level_solid_stride = 0;
+
+// The map in place until the first set_level_data()
+static const std::vector<std::string> default_level = {
     "################",
     "#..............#",
     "#..##..##..##..#",
@@ -24,40 +35,374 @@ std::vector<std::string> level_data = {
     "##############D#"
 };
 
+// A stored floor: padded tile grid and solidity mask behind level_tiles /
+// level_solid, either owned here or a mapped .mvm file laid out the same
+// way. The grid keeps a few spare bytes at the end so a 4-byte (gathered)
+// load of the last border tile stays inside the allocation.
+static const int TILE_LOAD_SLACK = 3;
+struct StoredFloor {
+    int w = 0, h = 0;
+    std::vector<char> tiles;
+    std::vector<uint64_t> solid;
+    engine::MapFile mapped;
+    char* tile_base = nullptr;    // border tile (-1, -1)
+    uint64_t* solid_base = nullptr;
+    std::pair<int,int> entrance = {-1, -1};
+    std::pair<int,int> exit = {-1, -1};
+
+    ~StoredFloor() { engine::map_file_close(mapped); }
+};
+
+void StoredFloorDeleter::operator()(StoredFloor* floor) const { delete floor; }
+
+// One set_tile() on a rebuildable floor: row-major tile index and new tile
+struct TileEdit {
+    uint32_t pos;
+    char tile;
+};
+
+// A floor's slot. floor is null while a rebuildable floor is dropped; it
+// lives behind a pointer so activating one never moves another. Every floor
+// ever added keeps one, so it holds no more than a dropped floor needs (24
+// bytes); the rest is kept only where there is some.
+struct FloorRecord {
+    FloorPtr floor;
+    unsigned seed = 0;
+    int w = 0, h = 0;
+    bool rebuildable = false;
+};
+
+// The set_tile() edits of a rebuildable floor, for floors that have any
+struct EditLog {
+    std::vector<TileEdit> edits;
+    size_t compacted = 0; // length after the last compact_edits()
+};
+
+// A rebuildable floor in memory and when it was last current
+struct BuiltFloor {
+    int idx;
+    uint64_t last_used;
+};
+
+static std::vector<FloorRecord> floors;
+static StoredFloor* active = nullptr;
+
+static FloorRebuild floor_rebuild = nullptr;
+static int max_built_floors = 0;
+static std::vector<BuiltFloor> built_floors;
+static std::unordered_map<int, EditLog> floor_edits;
+static uint64_t use_clock = 0;
+
 static int current_floor = 0;
-static std::pair<int,int> entrance_pos = {1,1};
-static std::pair<int,int> exit_pos = {14,13};
+static unsigned level_version = 1;
+static std::vector<std::pair<int,int>> tile_changes;
+// Past this many edits consumers rebuild from scratch instead
+static const size_t MAX_TILE_CHANGES = 4096;
+
+// Points the level at a floor's storage
+static void activate(StoredFloor& f) {
+    active = &f;
+    MAP_W = f.w;
+    MAP_H = f.h;
+    level_stride = f.w + 2;
+    level_solid_stride = (level_stride + 63) / 64;
+    level_tiles = f.tile_base + level_stride + 1;
+    level_solid = f.solid_base;
+}
+
+static void set_solid_bit(StoredFloor& f, int x, int y, bool on) {
+    const unsigned bit = (unsigned)(x + 1);
+    const int stride = (f.w + 2 + 63) / 64;
+    uint64_t& word = f.solid_base[(size_t)(y + 1) * stride + (bit >> 6)];
+    const uint64_t mask = (uint64_t)1 << (bit & 63);
+    word = on ? word | mask : word & ~mask;
+}
+
+// Copies a map into a floor's padded grid and rebuilds its solidity mask
+static void store_floor(StoredFloor& f, const std::vector<std::string>& data) {
+    engine::map_file_close(f.mapped);
+    f.w = data[0].size();
+    f.h = data.size();
+    const size_t stride = f.w + 2;
+    // Everything starts as wall, which leaves the border in place
+    f.tiles.assign(stride * (f.h + 2) + TILE_LOAD_SLACK, TILE_WALL);
+    f.solid.assign((stride + 63) / 64 * (f.h + 2), 0);
+    f.tile_base = f.tiles.data();
+    f.solid_base = f.solid.data();
+    for (int y = 0; y < f.h; ++y) {
+        const std::string& row = data[y];
+        char* dst = f.tile_base + (size_t)(y + 1) * stride + 1;
+        for (int x = 0; x < f.w && x < (int)row.size(); ++x)
+            dst[x] = row[x];
+    }
+    for (int y = -1; y <= f.h; ++y)
+        for (int x = -1; x <= f.w; ++x)
+            if (is_solid(f.tile_base[(size_t)(y + 1) * stride + x + 1]))
+                set_solid_bit(f, x, y, true);
+}
+
+// Finds the entrance ('E') and exit ('X') tiles
+static void scan_doorways(StoredFloor& f) {
+    const size_t stride = f.w + 2;
+    f.entrance = {-1, -1};
+    f.exit = {-1, -1};
+    for (int y = 0; y < f.h; ++y) {
+        const char* row = f.tile_base + (size_t)(y + 1) * stride + 1;
+        for (int x = 0; x < f.w; ++x) {
+            if (row[x] == TILE_ENTRANCE) f.entrance = {x, y};
+            if (row[x] == TILE_EXIT) f.exit = {x, y};
+        }
+    }
+}
+
+// Consumers key their caches on the version, so any new tiles bump it
+static void level_replaced() {
+    ++level_version;
+    tile_changes.clear();
+}
+
+// Keeps only the last edit of each tile, in tile order
+static void compact_edits(EditLog& log) {
+    std::vector<TileEdit>& edits = log.edits;
+    std::stable_sort(edits.begin(), edits.end(), [](const TileEdit& a, const TileEdit& b) { return a.pos < b.pos; });
+    size_t out = 0;
+    for (size_t i = 0; i < edits.size(); ++i) {
+        if (out > 0 && edits[out - 1].pos == edits[i].pos)
+            --out;
+        edits[out++] = edits[i];
+    }
+    edits.resize(out);
+    edits.shrink_to_fit();
+    log.compacted = edits.size();
+}
+
+static std::vector<BuiltFloor>::iterator find_built(int idx) {
+    return std::find_if(built_floors.begin(), built_floors.end(), [idx](const BuiltFloor& b) { return b.idx == idx; });
+}
+
+// A floor is no longer what its seed generates, so it stays in memory from now on
+static void pin_floor(int idx) {
+    FloorRecord& r = floors[idx];
+    if (!r.rebuildable)
+        return;
+    r.rebuildable = false;
+    floor_edits.erase(idx);
+    const auto it = find_built(idx);
+    if (it != built_floors.end())
+        built_floors.erase(it);
+}
+
+// Drops the least recently used rebuildable floors past the limit, never the
+// current one
+static void drop_unused_floors() {
+    while ((int)built_floors.size() > max_built_floors) {
+        size_t oldest = built_floors.size();
+        for (size_t i = 0; i < built_floors.size(); ++i) {
+            if (built_floors[i].idx != current_floor &&
+                (oldest == built_floors.size() || built_floors[i].last_used < built_floors[oldest].last_used))
+                oldest = i;
+        }
+        if (oldest == built_floors.size())
+            return;
+        const int idx = built_floors[oldest].idx;
+        const auto log = floor_edits.find(idx);
+        if (log != floor_edits.end())
+            compact_edits(log->second);
+        floors[idx].floor.reset();
+        built_floors.erase(built_floors.begin() + oldest);
+    }
+}
+
+// Brings a dropped floor back: same seed, same size, then its edits
+static bool rebuild_floor(int idx) {
+    FloorRecord& r = floors[idx];
+    FloorPtr f = floor_rebuild(idx, r.seed, r.w, r.h);
+    if (!f || f->w != r.w || f->h != r.h)
+        return false;
+    const size_t stride = f->w + 2;
+    const auto log = floor_edits.find(idx);
+    if (log != floor_edits.end()) {
+        for (const TileEdit& e : log->second.edits) {
+            const int x = e.pos % f->w, y = e.pos / f->w;
+            f->tile_base[(size_t)(y + 1) * stride + x + 1] = e.tile;
+            set_solid_bit(*f, x, y, is_solid(e.tile));
+        }
+    }
+    r.floor = std::move(f);
+    built_floors.push_back({idx, use_clock});
+    return true;
+}
 
 int get_current_floor() { return current_floor; }
-void set_current_floor(int idx) { current_floor = idx; }
+
+void set_current_floor(int idx) {
+    assert(idx >= 0 && idx < (int)floors.size());
+    FloorRecord& r = floors[idx];
+    ++use_clock;
+    const auto built = find_built(idx);
+    if (built != built_floors.end())
+        built->last_used = use_clock;
+    if (r.floor && active == r.floor.get())
+        return;
+    if (!r.floor && !rebuild_floor(idx)) {
+        LOG_ERROR(General, "Cannot rebuild floor %d (seed %u)", idx, r.seed);
+        return;
+    }
+    current_floor = idx;
+    activate(*r.floor);
+    level_replaced();
+    drop_unused_floors();
+}
+
+int get_floor_count() { return (int)floors.size(); }
+
+void set_floor_rebuild(FloorRebuild rebuild, int max_built) {
+    floor_rebuild = rebuild;
+    max_built_floors = std::max(1, max_built);
+    drop_unused_floors();
+}
+
+bool is_floor_built(int idx) { return idx >= 0 && idx < (int)floors.size() && floors[idx].floor; }
+
+FloorPtr make_floor(const std::vector<std::string>& data, std::pair<int,int> entrance, std::pair<int,int> exit) {
+    assert(!data.empty());
+    FloorPtr f(new StoredFloor);
+    store_floor(*f, data);
+    f->entrance = entrance;
+    f->exit = exit;
+    return f;
+}
+
+int add_floor(FloorPtr floor) {
+    assert(floor);
+    floors.emplace_back();
+    floors.back().floor = std::move(floor);
+    return (int)floors.size() - 1;
+}
+
+int add_floor(FloorPtr floor, unsigned seed) {
+    const int idx = add_floor(std::move(floor));
+    if (!floor_rebuild)
+        return idx;
+    FloorRecord& r = floors[idx];
+    r.rebuildable = true;
+    r.seed = seed;
+    r.w = r.floor->w;
+    r.h = r.floor->h;
+    built_floors.push_back({idx, ++use_clock});
+    return idx;
+}
+
+int add_floor(const std::vector<std::string>& data, std::pair<int,int> entrance, std::pair<int,int> exit) {
+    return add_floor(make_floor(data, entrance, exit));
+}
+
+int add_floor(const std::vector<std::string>& data) {
+    const int idx = add_floor(data, {-1, -1}, {-1, -1});
+    scan_doorways(*floors[idx].floor);
+    return idx;
+}
 
 void set_level_data(const std::vector<std::string>& data) {
     assert(!data.empty());
-    level_data = data;
-    MAP_H = level_data.size();
-    MAP_W = level_data[0].size();
-    // Find entrance/exit
-    entrance_pos = {-1,-1};
-    exit_pos = {-1,-1};
-    // Find entrance ('E') and exit ('X') tiles
-    entrance_pos = {-1, -1};
-    exit_pos = {-1, -1};
-    for (int y = 0; y < MAP_H; ++y) {
-        for (int x = 0; x < MAP_W; ++x) {
-            if (level_data[y][x] == TILE_ENTRANCE) entrance_pos = {x, y};
-            if (level_data[y][x] == TILE_EXIT) exit_pos = {x, y};
+    pin_floor(current_floor);
+    store_floor(*active, data);
+    scan_doorways(*active);
+    activate(*active);
+    level_replaced();
+}
+
+// What the level relies on in a mapped floor and map_file_open() doesn't
+// check: a wall border (unchecked reads and ray marches stop at it), a
+// solidity mask that matches the tiles, and an entrance and exit on the map
+// (or none)
+static bool check_floor_file(const engine::MapFile& file) {
+    const engine::MapFileHeader& hdr = *file.header;
+    const int w = (int)hdr.w, h = (int)hdr.h;
+    const size_t stride = (size_t)w + 2, solid_stride = (stride + 63) / 64;
+    for (int y = -1; y <= h; ++y) {
+        const char* row = file.tiles + (size_t)(y + 1) * stride + 1;
+        const uint64_t* solid = file.solid + (size_t)(y + 1) * solid_stride;
+        for (int x = -1; x <= w; ++x) {
+            const unsigned bit = (unsigned)(x + 1);
+            const bool border = x < 0 || x >= w || y < 0 || y >= h;
+            if ((border && row[x] != TILE_WALL) || (bool)(solid[bit >> 6] >> (bit & 63) & 1) != is_solid(row[x]))
+                return false;
         }
     }
+    auto on_map = [w, h](int x, int y) { return (x == -1 && y == -1) || (x >= 0 && x < w && y >= 0 && y < h); };
+    return on_map(hdr.entrance_x, hdr.entrance_y) && on_map(hdr.exit_x, hdr.exit_y);
+}
+
+bool load_level_file(const char* path) {
+    engine::MapFile file;
+    if (!engine::map_file_open(path, file))
+        return false;
+    if (!check_floor_file(file)) {
+        LOG_WARN(Assets, "Ignoring map with a broken border, solid mask or doorways: %s", path);
+        engine::map_file_close(file);
+        return false;
+    }
+    pin_floor(current_floor);
+    StoredFloor& f = *active;
+    engine::map_file_close(f.mapped);
+    f.mapped = std::move(file);
+    f.tiles = std::vector<char>();
+    f.solid = std::vector<uint64_t>();
+    const engine::MapFileHeader& hdr = *f.mapped.header;
+    f.w = hdr.w;
+    f.h = hdr.h;
+    f.tile_base = f.mapped.tiles;
+    f.solid_base = f.mapped.solid;
+    f.entrance = {hdr.entrance_x, hdr.entrance_y};
+    f.exit = {hdr.exit_x, hdr.exit_y};
+    activate(f);
+    level_replaced();
+    return true;
+}
+
+bool save_level_file(const char* path) {
+    const StoredFloor& f = *active;
+    return engine::map_file_write(path, f.w, f.h, f.tile_base, f.solid_base, f.entrance.first, f.entrance.second,
+                                  f.exit.first, f.exit.second);
 }
 
-std::pair<int,int> get_entrance_pos() { return entrance_pos; }
-std::pair<int,int> get_exit_pos() { return exit_pos; }
+std::pair<int,int> get_entrance_pos() { return active->entrance; }
+std::pair<int,int> get_exit_pos() { return active->exit; }
 
 char get_tile(int x, int y) {
     if (x < 0 || x >= MAP_W || y < 0 || y >= MAP_H) return TILE_WALL;
-    return level_data[y][x];
+    return get_tile_unchecked(x, y);
 }
 
+void set_tile(int x, int y, char tile) {
+    if (x < 0 || x >= MAP_W || y < 0 || y >= MAP_H) return;
+    char& cur = active->tile_base[(size_t)(y + 1) * level_stride + x + 1];
+    if (cur == tile) return;
+    cur = tile;
+    set_solid_bit(*active, x, y, is_solid(tile));
+    if (floors[current_floor].rebuildable) {
+        EditLog& log = floor_edits[current_floor];
+        log.edits.push_back({(uint32_t)(y * MAP_W + x), tile});
+        // Repeated edits of the same tiles don't grow the log for long
+        if (log.edits.size() >= 2 * log.compacted + 1024)
+            compact_edits(log);
+    }
+    if (tile_changes.size() >= MAX_TILE_CHANGES) {
+        level_replaced();
+    } else {
+        tile_changes.emplace_back(x, y);
+    }
+}
+
+unsigned get_level_version() { return level_version; }
+const std::vector<std::pair<int,int>>& get_tile_changes() { return tile_changes; }
+
 bool is_walkable(char tile) {
     return tile == TILE_FLOOR;
 }
+
+// Floor 0 holds the default map before anything reads the level. Its
+// entrance and exit were fixed before doorway tiles existed, so they are
+// given rather than scanned.
+static const bool default_level_loaded = (activate(*floors[add_floor(default_level, {1, 1}, {14, 13})].floor), true);
@@ -1,19 +1,79 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
+#include <utility>
 
 // Level dimensions and tile definitions
 extern int MAP_W, MAP_H;
-extern std::vector<std::string> level_data;
 
-// Track current floor index (0 = static, >=1 = random)
+// Level storage: one row-major buffer of (MAP_W + 2) x (MAP_H + 2) tiles with
+// a solid wall border, so any coordinate at most one tile outside the map
+// reads as a wall. level_tiles points at tile (0,0) of the current floor;
+// rows are level_stride apart. Repointed by set_current_floor() and replaced
+// by set_level_data(), so don't hold on to it across those.
+extern const char* level_tiles;
+extern int level_stride;
+
+// Bit-packed solidity over the same padded grid: one bit per tile, rows of
+// level_solid_stride 64-bit words, tile (x,y) at bit x + 1 of row y + 1.
+// Set where is_solid() holds, including the border.
+extern const uint64_t* level_solid;
+extern int level_solid_stride;
+
+// Floors are stored once, each with its tiles, solidity mask, entrance and
+// exit; the level is always one of them (floor 0, the static map, at
+// startup). Switching to a floor in memory only repoints the level at it: no
+// copy, no scan, no allocation. Edits go to the current floor and stay with it.
+// Floor indices: 0 = static, >= 1 = random.
 int get_current_floor();
 void set_current_floor(int idx);
+int get_floor_count();
+
+// Stores a new floor and returns its index; the current floor doesn't change.
+// Pass the entrance and exit when the generator already knows them, otherwise
+// the map is scanned for 'E' / 'X'.
+int add_floor(const std::vector<std::string>& data, std::pair<int,int> entrance, std::pair<int,int> exit);
+int add_floor(const std::vector<std::string>& data);
+
+// A floor's storage, built ahead of add_floor(). make_floor() does the copy
+// into level layout and touches nothing shared, so any thread may call it;
+// storing the result only takes ownership.
+struct StoredFloor;
+struct StoredFloorDeleter { void operator()(StoredFloor* floor) const; };
+using FloorPtr = std::unique_ptr<StoredFloor, StoredFloorDeleter>;
+FloorPtr make_floor(const std::vector<std::string>& data, std::pair<int,int> entrance, std::pair<int,int> exit);
+int add_floor(FloorPtr floor);
+
+// Generated floors can be dropped from memory and rebuilt when needed. Such a
+// floor is recorded as the seed and size it was generated from plus the
+// set_tile() edits made to it since; only the most recently used ones stay
+// built. Switching to one that was dropped rebuilds it through the callback
+// and replays its edits. A dropped floor costs a few dozen bytes, and its
+// edits (last one per tile) if it has any. Other floors (the static map,
+// loaded files, anything given to set_level_data()) always stay in memory.
+using FloorRebuild = FloorPtr (*)(int index, unsigned seed, int w, int h);
+void set_floor_rebuild(FloorRebuild rebuild, int max_built);
+// Stores a floor generated from seed; without a rebuild callback it is kept
+// like any other. Floors are dropped when another one becomes current.
+int add_floor(FloorPtr floor, unsigned seed);
+// Whether the floor's tiles are in memory right now
+bool is_floor_built(int idx);
 
-// Set level data (for random floors)
+// Replaces the current floor's tiles (entrance and exit are rescanned)
 void set_level_data(const std::vector<std::string>& data);
 
-// Get entrance/exit positions
+// Maps a binary floor (.mvm, engine/mapfile.h) in as the current floor,
+// entrance and exit included; edits stay in memory. The file is checked
+// first, tile by tile: false (with a warning) when it is malformed, isn't
+// walled all round, its solidity mask doesn't match its tiles or its
+// entrance/exit lie off the map. False leaves the current floor in place.
+bool load_level_file(const char* path);
+// Writes the current level as a .mvm
+bool save_level_file(const char* path);
+
+// Entrance/exit of the current floor
 std::pair<int,int> get_entrance_pos();
 std::pair<int,int> get_exit_pos();
 
@@ -26,3 +86,22 @@ constexpr char TILE_EXIT = 'X';     // Exit tile (maroon)
 // Level API
 char get_tile(int x, int y);
 bool is_walkable(char tile);
+// Stops rays: walls and the doorways drawn as walls
+inline bool is_solid(char tile) { return tile == TILE_WALL || tile == TILE_ENTRANCE || tile == TILE_EXIT; }
+
+// For hot loops: no bounds check, so x must be in [-1, MAP_W] and y in
+// [-1, MAP_H] (inside the border)
+inline char get_tile_unchecked(int x, int y) { return level_tiles[y * level_stride + x]; }
+inline bool is_solid_unchecked(int x, int y) {
+    const unsigned bit = (unsigned)(x + 1);
+    return (level_solid[(size_t)(y + 1) * level_solid_stride + (bit >> 6)] >> (bit & 63)) & 1;
+}
+
+// Edits one tile of the current level and records it in the change log
+void set_tile(int x, int y, char tile);
+
+// Change tracking for caches derived from the map. The version changes
+// whenever the map is replaced (and when the change log overflows); within
+// one version, get_tile_changes() lists every set_tile() in order.
+unsigned get_level_version();
+const std::vector<std::pair<int,int>>& get_tile_changes();
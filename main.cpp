@@ -5,19 +5,105 @@
 #include "level.h"
 #include "player.h"
 #include "render.h"
+#include "text.h"
 #include "random_floor.h"
+#include "engine/workers.h"
+#include "engine/assetpack.h"
+#include "engine/profile_sdl.h"
+#include "engine/log.h"
+#include "game/turnsystem.h"
+#include "game/entities.h"
+#include "game/pregen.h"
 #include <vector>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <unordered_map>
 
-struct FloorData {
-    std::vector<std::string> map;
-    std::pair<int,int> entrance, exit;
-    Monster monster;
+// The monsters of the floors in memory, by floor index (level.h), and what
+// each generated one spawned with. A floor the level dropped keeps only how
+// its monsters differ from that spawn, and nothing when they don't.
+static std::unordered_map<int, game::FloorEntities> floor_entities;
+static std::unordered_map<int, std::vector<Monster>> floor_spawns;
+static std::unordered_map<int, game::EntityDelta> floor_deltas;
+
+// Floor transition latency (doorway key to the player standing on the new
+// floor), bucketed by upper bound and reported on exit
+static const double TRANSITION_BUCKET_MS[] = {0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 1000};
+static const int TRANSITION_BUCKETS = sizeof(TRANSITION_BUCKET_MS) / sizeof(TRANSITION_BUCKET_MS[0]);
+struct TransitionStats {
+    unsigned counts[TRANSITION_BUCKETS + 1] = {}; // the last one is over 1 s
+    unsigned total = 0, pregenerated = 0;
+    double max_ms = 0;
 };
-static std::vector<FloorData> floors;
+static TransitionStats transitions;
 
 
 int main(int argc, char* argv[]) {
-    std::cout << "[DEBUG] Game loading..." << std::endl;
+    const auto start_time = std::chrono::steady_clock::now();
+    LOG_INFO(General, "Game loading...");
+    // Command line: --render=sdl (default) or --render=framebuffer,
+    // --threads=N for 3D view workers (0 = all cores, 1 = main thread only),
+    // --profile to start with the profiler overlay, --trace=file.json to
+    // record zones and write a Chrome trace on exit, --tick-ms=N to let
+    // monsters act every N ms even while the player waits, --log=file to log
+    // to a file instead of stderr, --log-level=debug|info|warn|error,
+    // --floor-size=WxH for generated floors (default: the first floor's
+    // size), --pregen=off to generate each floor only when it is entered,
+    // --seed=N to replay a run's floors (default: random), --floor-cache=N
+    // for how many generated floors stay in memory (default 8),
+    // --floor-styles=maze,caves,halls for the styles of generated floors,
+    // repeated going down, --map=file.mvm to start on a converted Tiled map
+    // (assets/maps/) instead of the static one
+    int render_threads = 0;
+    const char* log_path = nullptr;
+    engine::LogLevel log_level = engine::LogLevel::Debug;
+    int tick_ms = 0;
+    bool show_profiler = false;
+    const char* trace_path = nullptr;
+    int floor_w = 0, floor_h = 0;
+    bool pregen = true;
+    unsigned run_seed = 0;
+    int floor_cache = 8;
+    const char* floor_styles = nullptr;
+    const char* map_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--threads=", 10) == 0)
+            render_threads = atoi(argv[i] + 10);
+        if (strcmp(argv[i], "--profile") == 0)
+            show_profiler = true;
+        if (strncmp(argv[i], "--trace=", 8) == 0)
+            trace_path = argv[i] + 8;
+        if (strncmp(argv[i], "--tick-ms=", 10) == 0)
+            tick_ms = atoi(argv[i] + 10);
+        if (strncmp(argv[i], "--log=", 6) == 0)
+            log_path = argv[i] + 6;
+        if (strncmp(argv[i], "--floor-size=", 13) == 0 && sscanf(argv[i] + 13, "%dx%d", &floor_w, &floor_h) != 2)
+            floor_w = floor_h = 0;
+        if (strcmp(argv[i], "--pregen=off") == 0)
+            pregen = false;
+        if (strncmp(argv[i], "--seed=", 7) == 0)
+            run_seed = (unsigned)strtoul(argv[i] + 7, nullptr, 10);
+        if (strncmp(argv[i], "--floor-cache=", 14) == 0)
+            floor_cache = atoi(argv[i] + 14);
+        if (strncmp(argv[i], "--floor-styles=", 15) == 0)
+            floor_styles = argv[i] + 15;
+        if (strncmp(argv[i], "--map=", 6) == 0)
+            map_path = argv[i] + 6;
+        if (strncmp(argv[i], "--log-level=", 12) == 0) {
+            const char* lv = argv[i] + 12;
+            log_level = strcmp(lv, "error") == 0  ? engine::LogLevel::Error
+                        : strcmp(lv, "warn") == 0 ? engine::LogLevel::Warn
+                        : strcmp(lv, "info") == 0 ? engine::LogLevel::Info
+                                                  : engine::LogLevel::Debug;
+        }
+        if (strcmp(argv[i], "--render=framebuffer") == 0 || strcmp(argv[i], "--render=soft") == 0)
+            g_render_path = RenderPath::Framebuffer;
+        else if (strcmp(argv[i], "--render=sdl") == 0)
+            g_render_path = RenderPath::Renderer;
+    }
+    engine::log_set_level(log_level);
+    LOG_INFO(Render, "3D view render path: %s", g_render_path == RenderPath::Framebuffer ? "framebuffer" : "sdl");
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) != 0) {
         std::cerr << "SDL_Init Error: " << SDL_GetError() << std::endl;
         return 1;
@@ -61,18 +147,9 @@ int main(int argc, char* argv[]) {
     }
     // Load main menu background
     SDL_Texture* menu_bg_tex = nullptr;
-    {
-        SDL_Surface* surf = IMG_Load("assets/Labyrinth_of_Moravor_Cover_800x600.png");
-        if (!surf) {
-            std::cerr << "IMG_Load failed for menu background: " << IMG_GetError() << std::endl;
-        } else {
-            menu_bg_tex = SDL_CreateTextureFromSurface(ren, surf);
-            SDL_FreeSurface(surf);
-            if (!menu_bg_tex) {
-                std::cerr << "SDL_CreateTextureFromSurface failed for menu background: " << SDL_GetError() << std::endl;
-            }
-        }
-    }
+    menu_bg_tex = load_image_texture(ren, "assets/Labyrinth_of_Moravor_Cover_800x600.png", nullptr);
+    if (!menu_bg_tex)
+        LOG_WARN(Assets, "Failed to load menu background");
     if (!load_dungeon_textures(ren)) {
         std::cerr << "Failed to load dungeon textures!" << std::endl;
         // Cleanup order: free textures, quit IMG, destroy renderer/window, quit SDL
@@ -83,6 +160,9 @@ int main(int argc, char* argv[]) {
         SDL_Quit();
         return 1;
     }
+    engine::log_init(log_path, log_level);
+    engine::workers_init(render_threads);
+    LOG_INFO(Render, "3D view threads: %d", engine::workers_thread_count());
 
     enum MenuOption { MENU_START, MENU_QUIT, MENU_COUNT };
     const char* menu_labels[MENU_COUNT] = {"Start Game", "Quit"};
@@ -92,36 +172,22 @@ int main(int argc, char* argv[]) {
     SDL_Event e;
     int mouse_x = 0, mouse_y = 0;
     bool in_game = false;
+    // 3D view timing, reported on exit to compare render paths
+    Uint64 view_ticks = 0, view_frames = 0;
+    bool startup_reported = false;
+    // Profiler: F3 toggles the overlay, F4 writes a trace
+    TTF_Font* overlay_font = show_profiler ? TTF_OpenFont(fontPath, 14) : nullptr;
+    engine::profiler_set_enabled(show_profiler || trace_path);
     // --- Player and Level State ---
     // Party setup
     Party party;
     party.count = 1;
     player_init(party.members[0]);
 
-    // Helper: find a walkable tile for monster spawn (not at player or exit)
-    auto find_monster_spawn = [](const std::vector<std::string>& map, int px, int py, int ex, int ey) {
-        // Try to find a walkable tile not at player or exit
-        for (int y = 1; y < (int)map.size()-1; ++y) {
-            for (int x = 1; x < (int)map[0].size()-1; ++x) {
-                if (map[y][x] == '.' && !(x == px && y == py) && !(x == ex && y == ey)) {
-                    return std::make_pair(x, y);
-                }
-            }
-        }
-        // Fallback: try to find any walkable tile
-        for (int y = 1; y < (int)map.size()-1; ++y) {
-            for (int x = 1; x < (int)map[0].size()-1; ++x) {
-                if (map[y][x] == '.') {
-                    return std::make_pair(x, y);
-                }
-            }
-        }
-        // As a last resort, return (1,1)
-        return std::make_pair(1, 1);
-    };
-
     // Initialize persistent floors
-    floors.clear();
+    floor_entities.clear();
+    floor_spawns.clear();
+    floor_deltas.clear();
     // Static map as floor 0
     // Static map with correct exit position
     std::vector<std::string> static_map = {
@@ -140,36 +206,172 @@ int main(int argc, char* argv[]) {
         "#..###.##..#...#",
         "##############X#"
     };
-    // Find exit position for static map (look for 'X')
-    std::pair<int,int> static_exit = {-1, -1};
-    for (int y = 0; y < (int)static_map.size(); ++y) {
-        for (int x = 0; x < (int)static_map[0].size(); ++x) {
-            if (static_map[y][x] == 'X') static_exit = {x, y};
+    set_current_floor(0);
+    set_level_data(static_map);
+    // A map given on the command line replaces it; the player starts beside
+    // its entrance, or on its first floor tile when it has none
+    std::vector<std::string> floor0 = static_map;
+    if (map_path && load_level_file(map_path)) {
+        floor0.assign(MAP_H, std::string(MAP_W, TILE_WALL));
+        for (int y = 0; y < MAP_H; ++y)
+            for (int x = 0; x < MAP_W; ++x)
+                floor0[y][x] = get_tile_unchecked(x, y);
+        static const int dx[4] = {0, 1, 0, -1}, dy[4] = {-1, 0, 1, 0};
+        const std::pair<int,int> entrance = get_entrance_pos();
+        bool placed = false;
+        for (int d = 0; d < 4 && entrance.first >= 0 && !placed; ++d) {
+            if (get_tile(entrance.first + dx[d], entrance.second + dy[d]) == TILE_FLOOR) {
+                party.members[0].x = entrance.first + dx[d];
+                party.members[0].y = entrance.second + dy[d];
+                party.members[0].dir = d;
+                placed = true;
+            }
+        }
+        for (int i = 0; i < MAP_W * MAP_H && !placed; ++i) {
+            if (floor0[i / MAP_W][i % MAP_W] == TILE_FLOOR) {
+                party.members[0].x = i % MAP_W;
+                party.members[0].y = i / MAP_W;
+                placed = true;
+            }
         }
+        LOG_INFO(Game, "Floor 0 is %s (%dx%d)", map_path, MAP_W, MAP_H);
     }
-    // Find monster spawn for static map
-    auto monster_spawn = find_monster_spawn(static_map, 1, 1, static_exit.first, static_exit.second);
+    // Find monster spawn for floor 0
+    const std::pair<int,int> static_exit = get_exit_pos();
+    auto monster_spawn = game::find_monster_spawn(floor0, party.members[0].x, party.members[0].y, static_exit.first,
+                                                  static_exit.second);
     Monster static_monster;
     static_monster.x = monster_spawn.first;
     static_monster.y = monster_spawn.second;
     static_monster.dir = 1;
     static_monster.state = MonsterState::Idle;
-    // Place 'M' in the map for the monster
-    static_map[static_monster.y][static_monster.x] = 'M';
-    std::cout << "[DEBUG] Monster spawned at: (" << static_monster.x << ", " << static_monster.y << ") on static floor 0" << std::endl;
-    floors.push_back(FloorData{
-        static_map,
-        {1,1}, static_exit,
-        static_monster
-    });
-    set_level_data(floors[0].map);
+    LOG_DEBUG(Game, "Monster spawned at: (%d, %d) on static floor 0", static_monster.x, static_monster.y);
+    game::entities_reset(floor_entities[0], MAP_W, MAP_H);
+    game::entities_add(floor_entities[0], static_monster);
+    if (floor_w < 16 || floor_h < 16) {
+        floor_w = MAP_W;
+        floor_h = MAP_H;
+    }
 
+    // Generated floors are kept as their seed (derived from the run's) and
+    // their edits; only the last floor_cache visited stay in memory, the rest
+    // are generated again on the way back
+    if (!run_seed)
+        run_seed = std::random_device{}();
+    LOG_INFO(Game, "Run seed: %u", run_seed);
+    if (floor_styles) {
+        std::vector<FloorStyle> styles;
+        if (parse_floor_styles(floor_styles, styles))
+            game::set_floor_styles(std::move(styles));
+        else
+            LOG_WARN(Game, "Unknown floor style in %s", floor_styles);
+    }
+    set_floor_rebuild(game::rebuild_floor, floor_cache);
+    // Monsters of floors the player isn't on are kept without their
+    // occupancy grid; those of floors the level dropped, as a delta
+    auto enter_floor = [&](int idx) {
+        const int prev = get_current_floor();
+        set_current_floor(idx);
+        const int curr = get_current_floor();
+        if (curr != prev && floor_entities.count(prev))
+            game::entities_pack(floor_entities[prev]);
+        if (floor_entities.count(curr)) {
+            game::entities_unpack(floor_entities[curr], MAP_W, MAP_H);
+        } else {
+            // Rebuilt from its seed: its spawn again, then what changed
+            std::vector<Monster>& spawn = floor_spawns[curr];
+            if (!game::take_rebuilt_spawn(curr, spawn))
+                LOG_ERROR(Game, "No monster spawn for rebuilt floor %d", curr);
+            auto delta = floor_deltas.find(curr);
+            game::entities_restore(floor_entities[curr], spawn,
+                                   delta != floor_deltas.end() ? delta->second : game::EntityDelta(), MAP_W, MAP_H);
+            if (delta != floor_deltas.end())
+                floor_deltas.erase(delta);
+        }
+        for (auto it = floor_entities.begin(); it != floor_entities.end();) {
+            if (is_floor_built(it->first)) {
+                ++it;
+                continue;
+            }
+            game::EntityDelta delta;
+            game::entities_drop(it->second, floor_spawns[it->first], delta);
+            if (!delta.changed.empty())
+                floor_deltas[it->first] = std::move(delta);
+            floor_spawns.erase(it->first);
+            it = floor_entities.erase(it);
+        }
+    };
 
+    // The floor below the current one is built in the background as soon as
+    // the player arrives, so the stairs down only have to store it
+    auto pregen_next = [&]() {
+        const int next = get_current_floor() + 1;
+        if (pregen && next >= get_floor_count())
+            game::pregen_request(next, floor_w, floor_h, game::floor_seed(run_seed, next));
+    };
+    pregen_next();
+    auto transition_done = [&](std::chrono::steady_clock::time_point t0, bool pregenerated) {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        int b = 0;
+        while (b < TRANSITION_BUCKETS && ms > TRANSITION_BUCKET_MS[b])
+            ++b;
+        ++transitions.counts[b];
+        ++transitions.total;
+        transitions.pregenerated += pregenerated;
+        transitions.max_ms = std::max(transitions.max_ms, ms);
+        LOG_DEBUG(Game, "Floor %d reached in %.3f ms%s", get_current_floor(), ms, pregenerated ? " (pre-generated)" : "");
+        pregen_next();
+    };
+
+    // Monsters act on the turn clock (game/turnsystem.h), not per frame. The
+    // scheduler holds the current floor's monsters (actor id = entity id)
+    // and is rebuilt when the floor changes.
+    int scheduled_floor = -1;
+    auto monster_turn = [&](game::ActorId id) {
+        game::monster_act(floor_entities[scheduled_floor], id);
+    };
+    auto schedule_floor = [&]() {
+        int curr = get_current_floor();
+        if (curr == scheduled_floor)
+            return;
+        game::turns_reset();
+        scheduled_floor = -1;
+        if (floor_entities.count(curr)) {
+            scheduled_floor = curr;
+            for (const Monster& m : floor_entities[curr].monsters)
+                game::turns_add_actor(m.agility);
+        }
+    };
+    // The player turned or moved: monsters due before their next action act
+    auto player_acted = [&]() {
+        schedule_floor();
+        if (scheduled_floor < 0)
+            return;
+        game::process_turn(party.members[0].agility, monster_turn);
+        // A floor can be scheduled with no monsters on it
+        const std::vector<Monster>& monsters = floor_entities[scheduled_floor].monsters;
+        if (!monsters.empty())
+            LOG_DEBUG(Game, "Player: pos=(%d,%d), Monster: pos=(%d,%d)", party.members[0].x, party.members[0].y,
+                      monsters[0].x, monsters[0].y);
+    };
+    Uint32 last_tick = SDL_GetTicks();
 
     while (!quit) {
         // Main loop
+        PROFILE_BEGIN(input_zone, "input");
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) quit = true;
+            else if (e.type == SDL_RENDER_TARGETS_RESET) invalidate_party_panel();
+            else if (e.type == SDL_RENDER_DEVICE_RESET) free_party_panel();
+            else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+                show_profiler = !show_profiler;
+                if (show_profiler && !overlay_font)
+                    overlay_font = TTF_OpenFont(fontPath, 14);
+                engine::profiler_set_enabled(show_profiler || trace_path);
+            }
+            else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4) {
+                engine::profiler_write_chrome_trace(trace_path ? trace_path : "moravor_trace.json");
+            }
             else if (in_menu && e.type == SDL_KEYDOWN) {
                 switch (e.key.keysym.sym) {
                     case SDLK_UP:
@@ -219,7 +421,7 @@ int main(int argc, char* argv[]) {
                         if (btn.w > 0 && btn.h > 0 &&
                             mx >= btn.x && mx < btn.x + btn.w &&
                             my >= btn.y && my < btn.y + btn.h) {
-                            std::cout << "Character " << (i+1) << " attacks!" << std::endl;
+                            LOG_INFO(Game, "Character %d attacks!", i + 1);
                             // TODO: trigger actual attack logic
                         }
                     }
@@ -232,133 +434,21 @@ int main(int argc, char* argv[]) {
                     in_menu = true;
                 } else if (e.key.keysym.sym == SDLK_LEFT) {
                     player_turn(party.members[0], -1);
-                    // Monster AI and debug after player turn
-                    int curr_floor = get_current_floor();
-                    if (curr_floor >= 0 && curr_floor < (int)floors.size()) {
-                        Monster& monster = floors[curr_floor].monster;
-                        std::string action;
-                        if (monster.state == MonsterState::Idle) {
-                            if (rand() % 2 == 0) {
-                                monster.dir = rand() % 4;
-                                action = "Turned";
-                            } else {
-                                static const int dx[4] = {0, 1, 0, -1};
-                                static const int dy[4] = {-1, 0, 1, 0};
-                                int nx = monster.x + dx[monster.dir];
-                                int ny = monster.y + dy[monster.dir];
-                                char tile = get_tile(nx, ny);
-                                if (is_walkable(tile)) {
-                                    if (floors[curr_floor].map[monster.y][monster.x] == 'M')
-                                        floors[curr_floor].map[monster.y][monster.x] = '.';
-                                    monster.x = nx;
-                                    monster.y = ny;
-                                    floors[curr_floor].map[monster.y][monster.x] = 'M';
-                                    action = "Walked";
-                                } else {
-                                    action = "Idle (blocked)";
-                                }
-                            }
-                        } else if (monster.state == MonsterState::Dead) {
-                            action = "Dead";
-                        } else {
-                            action = "Unknown";
-                        }
-                        const char* state_str = (monster.state == MonsterState::Idle ? "Idle" : (monster.state == MonsterState::Agro ? "Agro" : "Dead"));
-                        const char* dir_strs[4] = {"N", "E", "S", "W"};
-                        std::cout << "[DEBUG] Monster: state=" << state_str
-                                  << ", pos=(" << monster.x << "," << monster.y << ")"
-                                  << ", dir=" << dir_strs[monster.dir%4]
-                                  << ", action=" << action << std::endl;
-std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.members[0].y << ")"
-          << ", Monster: pos=(" << monster.x << "," << monster.y << ")" << std::endl;
-                    }
+                    player_acted();
                 } else if (e.key.keysym.sym == SDLK_RIGHT) {
                     player_turn(party.members[0], 1);
-                    // Monster AI and debug after player turn
-                    int curr_floor = get_current_floor();
-                    if (curr_floor >= 0 && curr_floor < (int)floors.size()) {
-                        Monster& monster = floors[curr_floor].monster;
-                        std::string action;
-                        if (monster.state == MonsterState::Idle) {
-                            if (rand() % 2 == 0) {
-                                monster.dir = rand() % 4;
-                                action = "Turned";
-                            } else {
-                                static const int dx[4] = {0, 1, 0, -1};
-                                static const int dy[4] = {-1, 0, 1, 0};
-                                int nx = monster.x + dx[monster.dir];
-                                int ny = monster.y + dy[monster.dir];
-                                char tile = get_tile(nx, ny);
-                                if (is_walkable(tile)) {
-                                    if (floors[curr_floor].map[monster.y][monster.x] == 'M')
-                                        floors[curr_floor].map[monster.y][monster.x] = '.';
-                                    monster.x = nx;
-                                    monster.y = ny;
-                                    floors[curr_floor].map[monster.y][monster.x] = 'M';
-                                    action = "Walked";
-                                } else {
-                                    action = "Idle (blocked)";
-                                }
-                            }
-                        } else if (monster.state == MonsterState::Dead) {
-                            action = "Dead";
-                        } else {
-                            action = "Unknown";
-                        }
-                        const char* state_str = (monster.state == MonsterState::Idle ? "Idle" : (monster.state == MonsterState::Agro ? "Agro" : "Dead"));
-                        const char* dir_strs[4] = {"N", "E", "S", "W"};
-                        std::cout << "[DEBUG] Monster: state=" << state_str
-                                  << ", pos=(" << monster.x << "," << monster.y << ")"
-                                  << ", dir=" << dir_strs[monster.dir%4]
-                                  << ", action=" << action << std::endl;
-std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.members[0].y << ")"
-          << ", Monster: pos=(" << monster.x << "," << monster.y << ")" << std::endl;
-                    }
+                    player_acted();
                 } else if (e.key.keysym.sym == SDLK_UP) {
                     // Move forward in facing direction
                     static const int dx[4] = {0, 1, 0, -1};
                     static const int dy[4] = {-1, 0, 1, 0};
-                    player_move(party.members[0], dx[party.members[0].dir], dy[party.members[0].dir]);
-                    // Monster AI and debug after player move
-                    int curr_floor = get_current_floor();
-                    if (curr_floor >= 0 && curr_floor < (int)floors.size()) {
-                        Monster& monster = floors[curr_floor].monster;
-                        std::string action;
-                        if (monster.state == MonsterState::Idle) {
-                            if (rand() % 2 == 0) {
-                                monster.dir = rand() % 4;
-                                action = "Turned";
-                            } else {
-                                static const int dx[4] = {0, 1, 0, -1};
-                                static const int dy[4] = {-1, 0, 1, 0};
-                                int nx = monster.x + dx[monster.dir];
-                                int ny = monster.y + dy[monster.dir];
-                                char tile = get_tile(nx, ny);
-                                if (is_walkable(tile)) {
-                                    if (floors[curr_floor].map[monster.y][monster.x] == 'M')
-                                        floors[curr_floor].map[monster.y][monster.x] = '.';
-                                    monster.x = nx;
-                                    monster.y = ny;
-                                    floors[curr_floor].map[monster.y][monster.x] = 'M';
-                                    action = "Walked";
-                                } else {
-                                    action = "Idle (blocked)";
-                                }
-                            }
-                        } else if (monster.state == MonsterState::Dead) {
-                            action = "Dead";
-                        } else {
-                            action = "Unknown";
-                        }
-                        const char* state_str = (monster.state == MonsterState::Idle ? "Idle" : (monster.state == MonsterState::Agro ? "Agro" : "Dead"));
-                        const char* dir_strs[4] = {"N", "E", "S", "W"};
-                        std::cout << "[DEBUG] Monster: state=" << state_str
-                                  << ", pos=(" << monster.x << "," << monster.y << ")"
-                                  << ", dir=" << dir_strs[monster.dir%4]
-                                  << ", action=" << action << std::endl;
-std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.members[0].y << ")"
-          << ", Monster: pos=(" << monster.x << "," << monster.y << ")" << std::endl;
-                    }
+                    const int d = party.members[0].dir, floor = get_current_floor();
+                    // Monsters block the way
+                    if (!floor_entities.count(floor) ||
+                        game::entity_at(floor_entities[floor], party.members[0].x + dx[d], party.members[0].y + dy[d]) ==
+                            game::NO_ENTITY)
+                        player_move(party.members[0], dx[d], dy[d]);
+                    player_acted();
                 } else if (e.key.keysym.sym == SDLK_RETURN || e.key.keysym.sym == SDLK_KP_ENTER) {
                     // Check if facing doorway
                     static const int dx[4] = {0, 1, 0, -1};
@@ -366,25 +456,19 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
                     int nx = party.members[0].x + dx[party.members[0].dir];
                     int ny = party.members[0].y + dy[party.members[0].dir];
                     int floor = get_current_floor();
+                    const auto transition_start = std::chrono::steady_clock::now();
                     std::pair<int,int> curr_entrance = get_entrance_pos();
                     std::pair<int,int> curr_exit = get_exit_pos();
                     char tile = get_tile(nx, ny);
                     if (tile == TILE_EXIT || tile == TILE_ENTRANCE) {
                         if (tile == TILE_EXIT) {
-                            // Max floor check
-                            if (floor + 1 >= 10) {
-                                // End game, return to main menu
-                                in_game = false;
-                                in_menu = true;
-                                continue;
-                            }
                             // Go to next floor (persist)
-                            set_current_floor(floor + 1);
-                            if (floor + 1 < (int)floors.size()) {
-                                // Already generated, just load
-                                set_level_data(floors[floor + 1].map);
+                            bool pregenerated = false;
+                            if (floor + 1 < get_floor_count()) {
+                                // Already generated, just switch to it
+                                enter_floor(floor + 1);
                                 // Always place player by entrance of new floor, facing away from it
-                                std::pair<int,int> entrance = floors[floor + 1].entrance;
+                                std::pair<int,int> entrance = get_entrance_pos();
                                 int dx[4] = {0,1,0,-1}, dy[4] = {-1,0,1,0};
                                 int ex = entrance.first, ey = entrance.second;
                                 for (int d = 0; d < 4; ++d) {
@@ -397,19 +481,18 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
                                     }
                                 }
                             } else {
-                                // Generate new floor
-                                std::pair<int,int> entrance, exitp;
-                                std::vector<std::string> next_map = generate_random_floor(MAP_W, MAP_H, entrance, exitp);
-                                // Spawn monster for this new floor
-                                auto monster_spawn = find_monster_spawn(next_map, entrance.first, entrance.second, exitp.first, exitp.second);
-                                Monster floor_monster;
-                                floor_monster.x = monster_spawn.first;
-                                floor_monster.y = monster_spawn.second;
-                                floor_monster.dir = 1;
-                                floor_monster.state = MonsterState::Idle;
-                                std::cout << "[DEBUG] Monster spawned at: (" << floor_monster.x << ", " << floor_monster.y << ") on floor " << floors.size() << std::endl;
-                                floors.push_back(FloorData{next_map, entrance, exitp, floor_monster});
-                                set_level_data(next_map);
+                                // Take the floor built in the background, or build it now
+                                game::FloorBuild next;
+                                pregenerated = pregen && game::pregen_take(floor + 1, next);
+                                if (!pregenerated)
+                                    game::generate_floor(floor + 1, floor_w, floor_h, game::floor_seed(run_seed, floor + 1), next);
+                                const int added = add_floor(std::move(next.storage), next.seed);
+                                for (const Monster& m : next.monsters)
+                                    LOG_DEBUG(Game, "Monster spawned at: (%d, %d) on floor %d", m.x, m.y, added);
+                                floor_spawns[added] = next.monsters;
+                                floor_entities[added].monsters = std::move(next.monsters);
+                                enter_floor(added);
+                                std::pair<int,int> entrance = get_entrance_pos();
                                 // Place player by entrance
                                 int dx[4] = {0,1,0,-1}, dy[4] = {-1,0,1,0};
                                 int ex = entrance.first, ey = entrance.second;
@@ -423,17 +506,16 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
                                     }
                                 }
                             }
+                            transition_done(transition_start, pregenerated);
                         } else if (get_tile(nx, ny) == TILE_ENTRANCE) {
                             // Go to previous floor
                             if (floor == 0) {
                                 // First level has no entrance, do nothing
                                 break;
                             }
-                            set_current_floor(floor - 1);
+                            enter_floor(floor - 1);
                             if (floor - 1 == 0) {
-                                // Static map
-                                set_level_data(floors[0].map);
-                                // Place player adjacent to exit doorway, facing inward
+                                // Static map: place player adjacent to exit doorway, facing inward
                                 std::pair<int,int> static_exit = get_exit_pos();
                                 int ex = static_exit.first, ey = static_exit.second;
                                 int px = ex, py = ey;
@@ -445,9 +527,7 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
                                 party.members[0].x = px;
                                 party.members[0].y = py;
                             } else {
-                                // For random floors, load from persistent vector
-                                set_level_data(floors[floor - 1].map);
-                                std::pair<int,int> prev_exit = floors[floor - 1].exit;
+                                std::pair<int,int> prev_exit = get_exit_pos();
                                 int ex = prev_exit.first, ey = prev_exit.second;
                                 for (int d = 0; d < 4; ++d) {
                                     int dx[4] = {0,1,0,-1}, dy[4] = {-1,0,1,0};
@@ -460,12 +540,27 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
                                     }
                                 }
                             }
+                            transition_done(transition_start, false);
                             break;
                         }
                     }
                 }
             }
         }
+        PROFILE_END(input_zone);
+        // Optional real-time mode: the clock also advances one reference
+        // action per tick_ms while the player waits
+        if (in_game && tick_ms > 0) {
+            Uint32 now = SDL_GetTicks();
+            while (now - last_tick >= (Uint32)tick_ms) {
+                last_tick += tick_ms;
+                schedule_floor();
+                if (scheduled_floor >= 0)
+                    game::turns_advance(game::turns_now() + game::BASE_ACTION_DELAY, monster_turn);
+            }
+        } else {
+            last_tick = SDL_GetTicks();
+        }
         // --- Doorway indicator logic ---
         bool show_doorway_indicator = false;
         if (in_game) {
@@ -491,26 +586,19 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
             }
         }
         SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
-        SDL_RenderClear(ren);
+        engine::prof_render_clear(ren);
         // Draw floor number in top left when in game
         if (in_game) {
             char level_buf[32];
             snprintf(level_buf, sizeof(level_buf), "Floor: %d", get_current_floor());
             SDL_Color white = {255,255,255,255};
-            SDL_Surface* surf = TTF_RenderText_Blended(font, level_buf, white);
-            if (surf) {
-                SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                SDL_Rect rect = {20, 20, surf->w, surf->h};
-                SDL_RenderCopy(ren, tex, nullptr, &rect);
-                SDL_FreeSurface(surf);
-                SDL_DestroyTexture(tex);
-            }
+            draw_text(ren, font, level_buf, 20, 20, white);
         }
         if (in_menu) {
             // Draw menu background image if loaded
             if (menu_bg_tex) {
                 SDL_Rect bg_rect = {0, 0, 800, 600};
-                SDL_RenderCopy(ren, menu_bg_tex, nullptr, &bg_rect);
+                engine::prof_render_copy(ren, menu_bg_tex, nullptr, &bg_rect);
             }
             // Draw menu
             const int menu_x = 300, menu_y = 200, menu_w = 200, menu_h = 60;
@@ -521,100 +609,97 @@ std::cout << "[DEBUG] Player: pos=(" << party.members[0].x << "," << party.membe
                 } else {
                     SDL_SetRenderDrawColor(ren, 80, 80, 80, 255); // Normal
                 }
-                SDL_RenderFillRect(ren, &item);
+                engine::prof_render_fill_rect(ren, &item);
                 // Render text
                 SDL_Color fg = {255,255,255,255};
-                SDL_Surface* surf = TTF_RenderUTF8_Blended(font, menu_labels[i], fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        int tw = surf->w, th = surf->h;
-                        SDL_Rect dst = {item.x + (item.w-tw)/2, item.y + (item.h-th)/2, tw, th};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    SDL_FreeSurface(surf);
-                }
+                draw_text_centered(ren, font, menu_labels[i], item, fg);
             }
         } else if (in_game) {
             int win_w = 0, win_h = 0;
             SDL_GetWindowSize(win, &win_w, &win_h);
             int top_h = win_h * 0.6;
             int bottom_h = win_h - top_h;
-            // --- Monster AI turn (idle: random turn or walk) ---
+            // Rendering only reads the world; monsters act on the turn clock
             int curr_floor = get_current_floor();
-            if (curr_floor >= 0 && curr_floor < (int)floors.size()) {
-                Monster& monster = floors[curr_floor].monster;
-                std::string action;
-                if (monster.state == MonsterState::Idle) {
-                    if (rand() % 2 == 0) {
-                        // Turn: random direction
-                        monster.dir = rand() % 4;
-                        action = "Turned";
-                    } else {
-                        // Walk: move forward if possible
-                        static const int dx[4] = {0, 1, 0, -1};
-                        static const int dy[4] = {-1, 0, 1, 0};
-                        int nx = monster.x + dx[monster.dir];
-                        int ny = monster.y + dy[monster.dir];
-                        char tile = get_tile(nx, ny);
-                        if (is_walkable(tile)) {
-                            // Remove 'M' from old location
-                            if (floors[curr_floor].map[monster.y][monster.x] == 'M')
-                                floors[curr_floor].map[monster.y][monster.x] = '.';
-                            monster.x = nx;
-                            monster.y = ny;
-                            // Place 'M' in new location
-                            floors[curr_floor].map[monster.y][monster.x] = 'M';
-                            action = "Walked";
-                        } else {
-                            action = "Idle (blocked)";
-                        }
-                    }
-                } else if (monster.state == MonsterState::Dead) {
-                    action = "Dead";
-                } else {
-                    action = "Unknown";
-                }
-                // Debug output
-                const char* state_str = (monster.state == MonsterState::Idle ? "Idle" : (monster.state == MonsterState::Agro ? "Agro" : "Dead"));
-                const char* dir_strs[4] = {"N", "E", "S", "W"};
-                std::cout << "[DEBUG] Monster: state=" << state_str
-                          << ", pos=(" << monster.x << "," << monster.y << ")"
-                          << ", dir=" << dir_strs[monster.dir%4]
-                          << ", action=" << action << std::endl;
-                render_dungeon(ren, party.members[0], &monster, win_w, top_h, bottom_h);
+            if (floor_entities.count(curr_floor)) {
+                const std::vector<Monster>& monsters = floor_entities[curr_floor].monsters;
+                PROFILE_ZONE("render_dungeon");
+                Uint64 t0 = SDL_GetPerformanceCounter();
+                render_dungeon(ren, party.members[0], monsters.data(), (int)monsters.size(), win_w, top_h, bottom_h);
+                view_ticks += SDL_GetPerformanceCounter() - t0;
             } else {
-                render_dungeon(ren, party.members[0], nullptr, win_w, top_h, bottom_h);
+                PROFILE_ZONE("render_dungeon");
+                Uint64 t0 = SDL_GetPerformanceCounter();
+                render_dungeon(ren, party.members[0], nullptr, 0, win_w, top_h, bottom_h);
+                view_ticks += SDL_GetPerformanceCounter() - t0;
             }
+            ++view_frames;
+            PROFILE_BEGIN(party_zone, "render_party_status");
             render_party_status(ren, party, font, win_w, top_h, bottom_h);
-            render_minimap(ren, party.members[0], win_w, top_h, bottom_h);
+            PROFILE_END(party_zone);
+            PROFILE_BEGIN(minimap_zone, "render_minimap");
+            if (floor_entities.count(curr_floor))
+                render_minimap(ren, party.members[0], floor_entities[curr_floor].monsters.data(),
+                               (int)floor_entities[curr_floor].monsters.size(), win_w, top_h, bottom_h);
+            else
+                render_minimap(ren, party.members[0], nullptr, 0, win_w, top_h, bottom_h);
+            PROFILE_END(minimap_zone);
             // Draw doorway indicator if needed
             if (show_doorway_indicator && font) {
                 const char* msg = "Press Enter to Enter Doorway";
                 SDL_Color fg = {255, 255, 64, 255};
-                SDL_Surface* surf = TTF_RenderUTF8_Blended(font, msg, fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        int tw = surf->w, th = surf->h;
-                        SDL_Rect dst = { (win_w-tw)/2, 32, tw, th };
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    SDL_FreeSurface(surf);
-                }
+                int tw = 0;
+                measure_text(ren, font, msg, &tw, nullptr);
+                draw_text(ren, font, msg, (win_w-tw)/2, 32, fg);
             }
         }
+        if (show_profiler) {
+            int win_w = 0, win_h = 0;
+            SDL_GetWindowSize(win, &win_w, &win_h);
+            render_profiler_overlay(ren, overlay_font, win_w, win_h);
+        }
+        PROFILE_BEGIN(present_zone, "present");
         SDL_RenderPresent(ren);
+        PROFILE_END(present_zone);
+        engine::profile_frame_end();
+        if (!startup_reported) {
+            // Cold start: process entry to the first presented menu frame
+            startup_reported = true;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+            LOG_INFO(General, "Startup to menu: %.1f ms (%s)", ms, engine::asset_pack_open() ? "asset pack" : "loose PNGs");
+        }
     }
     // Cleanup resources in reverse order of creation
-    std::cout << "[DEBUG] Game exiting..." << std::endl;
+    LOG_INFO(General, "Game exiting...");
+    if (view_frames > 0) {
+        double ms = 1000.0 * view_ticks / SDL_GetPerformanceFrequency() / view_frames;
+        LOG_INFO(Render, "3D view average: %.3f ms over %llu frames", ms, (unsigned long long)view_frames);
+    }
+    if (transitions.total > 0) {
+        LOG_INFO(Game, "Floor transitions: %u (%u pre-generated), max %.3f ms", transitions.total,
+                 transitions.pregenerated, transitions.max_ms);
+        for (int b = 0; b <= TRANSITION_BUCKETS; ++b)
+            if (transitions.counts[b] > 0) {
+                if (b < TRANSITION_BUCKETS)
+                    LOG_INFO(Game, "  <= %g ms: %u", TRANSITION_BUCKET_MS[b], transitions.counts[b]);
+                else
+                    LOG_INFO(Game, "  > %g ms: %u", TRANSITION_BUCKET_MS[b - 1], transitions.counts[b]);
+            }
+    }
+    if (trace_path)
+        engine::profiler_write_chrome_trace(trace_path);
     free_dungeon_textures();
+    free_party_panel();
+    free_minimap();
+    free_text_cache();
+    game::pregen_shutdown();
+    engine::workers_shutdown();
+    engine::log_shutdown();
     if (menu_bg_tex) SDL_DestroyTexture(menu_bg_tex);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     IMG_Quit();
+    if (overlay_font) TTF_CloseFont(overlay_font);
     TTF_CloseFont(font);
     TTF_Quit();
     SDL_Quit();
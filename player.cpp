@@ -14,7 +14,7 @@ void player_init(Player& player) {
 
 void player_move(Player& player, int dx, int dy) {
     int nx = player.x + dx, ny = player.y + dy;
-    char tile = get_tile(nx, ny);
+    char tile = get_tile_unchecked(nx, ny); // one step from the map stays in the border
     if (is_walkable(tile)) {
         player.x = nx; player.y = ny;
     }
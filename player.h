@@ -10,6 +10,7 @@ struct Monster {
     int x, y;
     int dir; // 0=N,1=E,2=S,3=W
     MonsterState state;
+    int agility = 4; // action rate, see game::action_delay
 };
 
 struct Player {
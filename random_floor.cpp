@@ -2,75 +2,397 @@
 #include "level.h"
 #include <random>
 #include <algorithm>
-#include <queue>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
 
 // Directions: N, E, S, W
 static const int dx[4] = {0, 1, 0, -1};
 static const int dy[4] = {-1, 0, 1, 0};
 
-// Helper: carve a path using randomized DFS
-static void carve_path(std::vector<std::string>& map, int x, int y, int ex, int ey, std::mt19937& rng, std::vector<std::vector<bool>>& visited) {
-    int w = map[0].size(), h = map.size();
-    visited[y][x] = true;
-    if (x == ex && y == ey) return;
-    std::vector<int> dirs = {0, 1, 2, 3};
-    std::shuffle(dirs.begin(), dirs.end(), rng);
-    for (int d : dirs) {
-        int nx = x + dx[d], ny = y + dy[d];
-        if (nx < 1 || nx >= w-1 || ny < 1 || ny >= h-1) continue;
-        if (!visited[ny][nx]) {
-            map[ny][nx] = '.';
-            carve_path(map, nx, ny, ex, ey, rng, visited);
+// Seeded the way std::mt19937 seeds itself
+FloorRng::FloorRng(uint32_t seed) {
+    state_[0] = seed;
+    for (int i = 1; i < N; ++i)
+        state_[i] = 1812433253u * (state_[i - 1] ^ state_[i - 1] >> 30) + (uint32_t)i;
+}
+
+void FloorRng::refill() {
+    const uint32_t UPPER = 0x80000000u, LOWER = 0x7FFFFFFFu, MATRIX = 0x9908B0DFu;
+    // Word i takes words i + 1 and i + M (mod N), the latter already twisted
+    // when it comes before i, so four words at a time work in place unless
+    // i + M wraps inside them
+#if defined(__SSE2__)
+    const __m128i upper = _mm_set1_epi32((int)UPPER), lower = _mm_set1_epi32((int)LOWER);
+    const __m128i matrix = _mm_set1_epi32((int)MATRIX), one = _mm_set1_epi32(1);
+#endif
+    for (int i = 0; i < N;) {
+        const int m = i + M < N ? i + M : i + M - N;
+#if defined(__SSE2__)
+        if (i + 4 < N && m + 4 <= N) {
+            const __m128i a = _mm_loadu_si128((const __m128i*)(state_ + i));
+            const __m128i b = _mm_loadu_si128((const __m128i*)(state_ + i + 1));
+            const __m128i c = _mm_loadu_si128((const __m128i*)(state_ + m));
+            const __m128i y = _mm_or_si128(_mm_and_si128(a, upper), _mm_and_si128(b, lower));
+            const __m128i odd = _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(y, one));
+            _mm_storeu_si128((__m128i*)(state_ + i),
+                             _mm_xor_si128(_mm_xor_si128(c, _mm_srli_epi32(y, 1)), _mm_and_si128(odd, matrix)));
+            i += 4;
+            continue;
         }
+#endif
+        const uint32_t y = (state_[i] & UPPER) | (state_[i + 1 < N ? i + 1 : 0] & LOWER);
+        state_[i] = state_[m] ^ y >> 1 ^ ((y & 1) ? MATRIX : 0);
+        ++i;
+    }
+    for (int i = 0; i < N; ++i) {
+        uint32_t y = state_[i];
+        y ^= y >> 11;
+        y ^= y << 7 & 0x9D2C5680u;
+        y ^= y << 15 & 0xEFC60000u;
+        out_[i] = y ^ y >> 18;
     }
+    next_ = 0;
 }
 
-std::vector<std::string> generate_random_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed) {
-    std::mt19937 rng(seed ? seed : std::random_device{}());
-    std::vector<std::string> map(h, std::string(w, '#'));
-    // 1. Place random rooms
-    int num_rooms = 3 + rng() % 4;
-    std::vector<std::pair<int,int>> room_centers;
-    for (int r = 0; r < num_rooms; ++r) {
-        int rw = 3 + rng() % 4; // room width
-        int rh = 3 + rng() % 4; // room height
-        int rx = 1 + rng() % (w - rw - 1);
-        int ry = 1 + rng() % (h - rh - 1);
-        for (int y = ry; y < ry+rh; ++y)
-            for (int x = rx; x < rx+rw; ++x)
-                map[y][x] = '.';
-        room_centers.emplace_back(rx+rw/2, ry+rh/2);
+namespace {
+// The 24 orders a maze cell can try the four directions in, as std::shuffle
+// puts them: libstdc++ shuffles four things with one draw of 2 (whether the
+// second swaps with the first) and one of 12 (where the third and fourth
+// swap to), so an order is numbered 12 * first + second. draw() makes the
+// same draws from the same numbers, without going through
+// uniform_int_distribution. first_open[order][mask] is the first direction
+// of the order whose bit is set in mask, 4 when there is none.
+struct MazeOrders {
+    uint8_t first_open[24][16];
+
+    MazeOrders() {
+        for (int n = 0; n < 24; ++n) {
+            int dirs[4] = {0, 1, 2, 3};
+            std::swap(dirs[1], dirs[n / 12]);
+            std::swap(dirs[2], dirs[n % 12 / 4]);
+            std::swap(dirs[3], dirs[n % 4]);
+            for (int mask = 0; mask < 16; ++mask) {
+                int i = 0;
+                while (i < 4 && !(mask >> dirs[i] & 1))
+                    ++i;
+                first_open[n][mask] = (uint8_t)(i < 4 ? dirs[i] : 4);
+            }
+        }
+    }
+
+    // The top bits of a multiply, redrawn in the rare case the low bits fall
+    // below 2^32 mod 12 (a draw of 2 never redraws)
+    static int draw(FloorRng& rng) {
+        const int first = (int)(rng() >> 31);
+        uint64_t product = (uint64_t)rng() * 12;
+        if ((uint32_t)product < 12)
+            while ((uint32_t)product < (uint32_t)-12 % 12)
+                product = (uint64_t)rng() * 12;
+        return first * 12 + (int)(product >> 32);
+    }
+};
+
+// Set bits in v; without the instruction GCC calls a library routine instead
+inline int popcount64(uint64_t v) {
+#if defined(__POPCNT__)
+    return __builtin_popcountll(v);
+#else
+    v -= v >> 1 & 0x5555555555555555ull;
+    v = (v & 0x3333333333333333ull) + (v >> 2 & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)(v * 0x0101010101010101ull >> 56);
+#endif
+}
+
+// Index of the lowest set bit in v, which must not be 0
+inline int ctz64(uint64_t v) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return (int)i;
+#elif defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    return popcount64((v & (0 - v)) - 1);
+#endif
+}
+
+// The floor tiles of a map as a bitboard, words_per_row 64-bit words per row
+// (tile x of row y at bit x & 63 of word y * words_per_row + (x >> 6)), cut
+// into runs: horizontal stretches of floor, numbered in row-major order. Run
+// boundaries come 64 tiles at a time from shifting a word against itself,
+// and runs touching across rows are joined in a union-find, so each set is
+// one connected area of floor.
+struct FloorRuns {
+    int w, h, words_per_row;
+    std::vector<uint64_t> open;
+    std::vector<uint32_t> first_run; // per word: runs starting in earlier words
+    std::vector<uint32_t> parent;    // per run: union-find link, roots point at themselves
+    uint32_t areas = 0;              // sets
+
+    // Runs starting in word i (carry: the top bit of the word before it)
+    uint64_t starts(size_t i) const {
+        const uint64_t carry = i % words_per_row ? open[i - 1] >> 63 : 0;
+        return open[i] & ~(open[i] << 1 | carry);
+    }
+    // The run holding floor tile (x, y)
+    uint32_t run_at(int x, int y) const {
+        const size_t i = (size_t)y * words_per_row + (x >> 6);
+        const uint64_t upto = ~(uint64_t)0 >> (63 - (x & 63));
+        return first_run[i] + popcount64(starts(i) & upto) - 1;
+    }
+    bool is_open(int x, int y) const {
+        return open[(size_t)y * words_per_row + (x >> 6)] >> (x & 63) & 1;
+    }
+    uint32_t find(uint32_t r) {
+        while (parent[r] != r) {
+            parent[r] = parent[parent[r]];
+            r = parent[r];
+        }
+        return r;
+    }
+    // The newer run becomes the root, which keeps the roots the labelling
+    // pass looks up near the rows it is on
+    void join(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+            parent[std::min(a, b)] = std::max(a, b);
+    }
+};
+
+// Bit x set where row[x] is floor, for n <= 64 tiles
+uint64_t floor_bits(const char* row, int n) {
+    uint64_t bits = 0;
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i dot = _mm_set1_epi8('.');
+    for (; x + 16 <= n; x += 16) {
+        const __m128i tiles = _mm_loadu_si128((const __m128i*)(row + x));
+        bits |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(tiles, dot)) << x;
+    }
+#endif
+    for (; x < n; ++x)
+        bits |= (uint64_t)(row[x] == '.') << x;
+    return bits;
+}
+
+void label_floor_runs(const std::vector<char*>& rows, FloorRuns& runs) {
+    const int w = runs.w, h = runs.h, wpr = runs.words_per_row;
+    runs.open.resize((size_t)wpr * h);
+    runs.first_run.resize(runs.open.size());
+    uint32_t count = 0;
+    for (int y = 0; y < h; ++y) {
+        uint64_t* dst = &runs.open[(size_t)y * wpr];
+        uint32_t* first = &runs.first_run[(size_t)y * wpr];
+        uint64_t carry = 0;
+        for (int k = 0; k < wpr; ++k) {
+            const uint64_t word = floor_bits(rows[y] + k * 64, std::min(64, w - k * 64));
+            dst[k] = word;
+            first[k] = count;
+            count += popcount64(word & ~(word << 1 | carry));
+            carry = word >> 63;
+        }
+    }
+    // Each row's runs start out alone, then join the runs above them: two
+    // runs on neighbouring rows touch once per stretch of floor they share.
+    // Runs are visited in order and every run above has a lower number, so
+    // the run being visited is always the root of its set.
+    runs.parent.resize(count);
+    uint32_t merges = 0;
+    for (int y = 0; y < h; ++y) {
+        const size_t row = (size_t)y * wpr, up = row - wpr;
+        const uint32_t row_end = y + 1 < h ? runs.first_run[row + wpr] : count;
+        for (uint32_t r = runs.first_run[row]; r < row_end; ++r)
+            runs.parent[r] = r;
+        if (y == 0)
+            continue;
+        uint64_t carry = 0, carry_up = 0, carry_shared = 0;
+        for (int k = 0; k < wpr; ++k) {
+            const uint64_t cur = runs.open[row + k], above = runs.open[up + k], shared = cur & above;
+            const uint64_t starts = cur & ~(cur << 1 | carry), starts_up = above & ~(above << 1 | carry_up);
+            uint64_t touch = shared & ~(shared << 1 | carry_shared);
+            carry = cur >> 63;
+            carry_up = above >> 63;
+            carry_shared = shared >> 63;
+            while (touch) {
+                const uint64_t upto = touch ^ (touch - 1); // up to the lowest touch
+                touch &= touch - 1;
+                const uint32_t a = runs.first_run[row + k] + popcount64(starts & upto) - 1;
+                const uint32_t b = runs.first_run[up + k] + popcount64(starts_up & upto) - 1;
+                const uint32_t root = runs.find(b);
+                merges += root != a;
+                runs.parent[root] = a;
+            }
+        }
+    }
+    runs.areas = count - merges;
+}
+
+// A stretch of floor outside the main area, waiting to be joined
+struct StrayRun {
+    uint32_t root;
+    int y, x0, x1;
+};
+
+// Joins every area of floor to the largest one, or the entrance's (the one
+// holding (sx, sy)) when that is no smaller. From each other area, a
+// breadth-first search through the inner walls finds the fewest walls to
+// knock down to reach floor of any other area; those become floor and the two
+// areas are one. Returns the areas there were.
+int join_floor_areas(const std::vector<char*>& rows, FloorRuns& runs, int sx, int sy, int& carved) {
+    const int w = runs.w, h = runs.h, wpr = runs.words_per_row;
+    carved = 0;
+    if (runs.areas <= 1)
+        return (int)runs.areas;
+    // Calls fn(root, y, x0, x1) for every stretch of floor
+    auto for_each_run = [&](auto fn) {
+        for (int y = 0; y < h; ++y) {
+            for (int k = 0; k < wpr; ++k) {
+                const size_t i = (size_t)y * wpr + k;
+                uint64_t starts = runs.starts(i);
+                uint32_t run = runs.first_run[i];
+                for (; starts; starts &= starts - 1, ++run) {
+                    int x = k * 64 + ctz64(starts);
+                    const int x0 = x;
+                    while (x + 1 < w && runs.is_open(x + 1, y))
+                        ++x;
+                    fn(runs.find(run), y, x0, x);
+                }
+            }
+        }
+    };
+    // The area the others join: searching from a big one would queue all of
+    // it (a doorway can be an area of one tile next to the rest of the floor)
+    uint32_t main_root = runs.find(runs.run_at(sx, sy));
+    {
+        std::vector<uint32_t> size(runs.parent.size(), 0);
+        for_each_run([&](uint32_t root, int, int x0, int x1) { size[root] += x1 - x0 + 1; });
+        for (uint32_t r = 0; r < size.size(); ++r)
+            if (size[r] > size[main_root])
+                main_root = r;
     }
-    // 2. Maze/hallways using randomized DFS from first room center
-    std::vector<std::vector<bool>> visited(h, std::vector<bool>(w, false));
-    auto maze_carve = [&](int x, int y, auto&& self) -> void {
-        visited[y][x] = true;
-        std::vector<int> dirs = {0,1,2,3};
-        std::shuffle(dirs.begin(), dirs.end(), rng);
-        for (int d : dirs) {
-            int nx = x + dx[d]*2, ny = y + dy[d]*2;
-            if (nx > 0 && nx < w-1 && ny > 0 && ny < h-1 && !visited[ny][nx]) {
-                map[y + dy[d]][x + dx[d]] = '.';
-                map[ny][nx] = '.';
-                self(nx, ny, self);
+    // Every stretch of floor outside that area, grouped by area
+    std::vector<StrayRun> stray;
+    for_each_run([&](uint32_t root, int y, int x0, int x1) {
+        if (root != main_root)
+            stray.push_back({root, y, x0, x1});
+    });
+    std::stable_sort(stray.begin(), stray.end(), [](const StrayRun& a, const StrayRun& b) { return a.root < b.root; });
+
+    struct Step {
+        int x, y;
+        int32_t from; // the step it came from, -1 for a floor tile of the area
+    };
+    std::vector<uint64_t> seen((size_t)wpr * h, 0);
+    std::vector<Step> steps;
+    auto mark = [&](int x, int y) { seen[(size_t)y * wpr + (x >> 6)] |= (uint64_t)1 << (x & 63); };
+    // Joining two areas that both miss the main one leaves one that still
+    // does, so go round until none is left
+    for (bool again = true; again;) {
+        again = false;
+        for (size_t b = 0; b < stray.size();) {
+            size_t e = b;
+            while (e < stray.size() && stray[e].root == stray[b].root)
+                ++e;
+            const uint32_t area = runs.find(stray[b].root);
+            if (area == runs.find(main_root)) {
+                b = e;
+                continue;
+            }
+            steps.clear();
+            for (size_t k = b; k < e; ++k)
+                for (int x = stray[k].x0; x <= stray[k].x1; ++x) {
+                    mark(x, stray[k].y);
+                    steps.push_back({x, stray[k].y, -1});
+                }
+            for (size_t head = 0; head < steps.size(); ++head) {
+                const Step at = steps[head];
+                int d = 0;
+                for (; d < 4; ++d) {
+                    const int nx = at.x + dx[d], ny = at.y + dy[d];
+                    if (runs.is_open(nx, ny)) {
+                        const uint32_t other = runs.find(runs.run_at(nx, ny));
+                        if (other == area)
+                            continue;
+                        for (int32_t s = (int32_t)head; s >= 0 && steps[s].from >= 0; s = steps[s].from) {
+                            char& tile = rows[steps[s].y][steps[s].x];
+                            carved += tile != '.';
+                            tile = '.';
+                        }
+                        runs.join(area, other);
+                        break;
+                    }
+                    // Only inner walls are knocked down, never the outer one
+                    if (nx < 1 || nx > w - 2 || ny < 1 || ny > h - 2 ||
+                        seen[(size_t)ny * wpr + (nx >> 6)] >> (nx & 63) & 1)
+                        continue;
+                    mark(nx, ny);
+                    steps.push_back({nx, ny, (int32_t)head});
+                }
+                if (d < 4) {
+                    again = true;
+                    break;
+                }
             }
+            for (const Step& s : steps)
+                seen[(size_t)s.y * wpr + (s.x >> 6)] = 0;
+            b = e;
         }
+    }
+    return (int)runs.areas;
+}
+// The walls to knock down so the floor tile (sx, sy) inside a doorway, on
+// its own (or with own, (-1, -1) when none), reaches other floor: the same
+// breadth-first search through the inner walls as join_floor_areas(), on the
+// map as labelled (floor carved since is still wall to it), so both carve
+// the same tiles. Appends them to path and returns the floor tile reached,
+// (-1, -1) when there is none.
+std::pair<int,int> doorway_path(const std::vector<char*>& rows, int w, int h, int sx, int sy, std::pair<int,int> own, std::vector<std::pair<int,int>>& path) {
+    struct Step {
+        int x, y;
+        int32_t from; // the step it came from, -1 for the doorway tile
     };
-    int startx = room_centers[0].first, starty = room_centers[0].second;
-    maze_carve(startx, starty, maze_carve);
-    // 3. Connect all rooms
-    for (size_t i = 1; i < room_centers.size(); ++i) {
-        int x0 = room_centers[i-1].first, y0 = room_centers[i-1].second;
-        int x1 = room_centers[i].first, y1 = room_centers[i].second;
-        while (x0 != x1 || y0 != y1) {
-            if (x0 < x1) ++x0;
-            else if (x0 > x1) --x0;
-            else if (y0 < y1) ++y0;
-            else if (y0 > y1) --y0;
-            map[y0][x0] = '.';
-        }
-    }
-    // 4. Randomize entrance/exit on outer wall (not corners)
+    std::vector<Step> steps = {{sx, sy, -1}};
+    std::unordered_set<int64_t> seen = {(int64_t)sy * w + sx};
+    for (size_t head = 0; head < steps.size(); ++head) {
+        const Step at = steps[head];
+        for (int d = 0; d < 4; ++d) {
+            const int nx = at.x + dx[d], ny = at.y + dy[d];
+            const char tile = rows[ny][nx];
+            if (tile == TILE_FLOOR) {
+                if ((nx == sx && ny == sy) || (nx == own.first && ny == own.second))
+                    continue;
+                for (int32_t s = (int32_t)head; steps[s].from >= 0; s = steps[s].from)
+                    path.emplace_back(steps[s].x, steps[s].y);
+                return {nx, ny};
+            }
+            // Only inner walls are knocked down, never the outer one
+            if (tile != TILE_WALL || nx < 1 || nx > w - 2 || ny < 1 || ny > h - 2 ||
+                !seen.insert((int64_t)ny * w + nx).second)
+                continue;
+            steps.push_back({nx, ny, (int32_t)head});
+        }
+    }
+    return {-1, -1};
+}
+} // namespace
+
+void finish_floor(std::vector<std::string>& map, FloorRng& rng, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, FloorGenStats* stats, bool connected) {
+    const int w = (int)map[0].size(), h = (int)map.size();
+    std::vector<char*> rows(h);
+    for (int y = 0; y < h; ++y)
+        rows[y] = &map[y][0];
+    // Randomize entrance/exit on outer wall (not corners)
     auto pick_wall_pos = [&](int& x, int& y) {
         int wall = rng()%4;
         if (wall == 0) { // top
@@ -93,43 +415,180 @@ std::vector<std::string> generate_random_floor(int w, int h, std::pair<int,int>&
     // Ensure tile next to entrance/exit is open
     int dx1 = (ex1==0)?1:(ex1==w-1)?-1:0, dy1 = (ey1==0)?1:(ey1==h-1)?-1:0;
     int dx2 = (ex2==0)?1:(ex2==w-1)?-1:0, dy2 = (ey2==0)?1:(ey2==h-1)?-1:0;
-    map[ey1][ex1] = TILE_ENTRANCE;
-    map[ey1+dy1][ex1+dx1] = TILE_FLOOR;
-    map[ey2][ex2] = TILE_EXIT;
-    map[ey2+dy2][ex2+dx2] = TILE_FLOOR;
+    rows[ey1][ex1] = TILE_ENTRANCE;
+    rows[ey1+dy1][ex1+dx1] = TILE_FLOOR;
+    rows[ey2][ex2] = TILE_EXIT;
+    rows[ey2+dy2][ex2+dx2] = TILE_FLOOR;
     entrance_pos = {ex1, ey1};
     exit_pos = {ex2, ey2};
 
-    // Ensure a path exists between entrance-adjacent and exit-adjacent tiles
-    int sx = ex1+dx1, sy = ey1+dy1;
-    int gx = ex2+dx2, gy = ey2+dy2;
-    std::vector<std::vector<bool>> bfs_visited(h, std::vector<bool>(w, false));
-    std::queue<std::pair<int,int>> q;
-    q.push({sx, sy}); bfs_visited[sy][sx] = true;
-    bool found = false;
-    while (!q.empty()) {
-        auto [x, y] = q.front(); q.pop();
-        if (x == gx && y == gy) { found = true; break; }
-        for (int d = 0; d < 4; ++d) {
-            int nx = x+dx[d], ny = y+dy[d];
-            if (nx < 0 || nx >= w || ny < 0 || ny >= h) continue;
-            if (!bfs_visited[ny][nx] && map[ny][nx] == '.') {
-                bfs_visited[ny][nx] = true;
-                q.push({nx, ny});
-            }
+    // Join every area of floor (rooms, the tiles by the doorways, ...) into
+    // one, so the entrance leads to all of it and to the exit. When the
+    // generator's floor is one area, only the doorway tiles can stand apart,
+    // each an area of one tile. They are joined as join_floor_areas() joins
+    // them: in row-major order (their runs' order), searching the map as it
+    // was, and a tile that reached the other lone one searches on with it.
+    if (connected) {
+        std::pair<int,int> doors[2] = {{ex1+dx1, ey1+dy1}, {ex2+dx2, ey2+dy2}};
+        if (std::make_pair(doors[1].second, doors[1].first) < std::make_pair(doors[0].second, doors[0].first))
+            std::swap(doors[0], doors[1]);
+        bool alone[2];
+        for (int i = 0; i < 2; ++i) {
+            alone[i] = true;
+            for (int d = 0; d < 4; ++d)
+                alone[i] &= rows[doors[i].second + dy[d]][doors[i].first + dx[d]] != TILE_FLOOR;
+        }
+        std::vector<std::pair<int,int>> path;
+        bool merged = false;
+        for (int i = 0; i < 2; ++i) {
+            if (!alone[i])
+                continue;
+            const std::pair<int,int> reached =
+                doorway_path(rows, w, h, doors[i].first, doors[i].second, merged ? doors[0] : std::make_pair(-1, -1), path);
+            merged = i == 0 && alone[1] && reached == doors[1];
+        }
+        int carved = 0;
+        for (const auto& t : path) {
+            carved += rows[t.second][t.first] != TILE_FLOOR;
+            rows[t.second][t.first] = TILE_FLOOR;
+        }
+        if (stats) {
+            stats->areas = 1 + alone[0] + alone[1];
+            stats->carved = carved;
         }
+        return;
+    }
+    FloorRuns runs{w, h, (w + 63) / 64, {}, {}, {}};
+    label_floor_runs(rows, runs);
+    int carved = 0;
+    const int areas = join_floor_areas(rows, runs, ex1+dx1, ey1+dy1, carved);
+    if (stats) {
+        stats->areas = areas;
+        stats->carved = carved;
+    }
+}
+
+std::vector<std::string> generate_random_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed, FloorGenStats* stats) {
+    FloorRng rng(seed ? seed : std::random_device{}());
+    std::vector<std::string> map(h, std::string(w, '#'));
+    std::vector<char*> rows(h);
+    for (int y = 0; y < h; ++y)
+        rows[y] = &map[y][0];
+    // 1. Place random rooms
+    int num_rooms = 3 + rng() % 4;
+    std::vector<std::pair<int,int>> room_centers;
+    for (int r = 0; r < num_rooms; ++r) {
+        int rw = 3 + rng() % 4; // room width
+        int rh = 3 + rng() % 4; // room height
+        int rx = 1 + rng() % (w - rw - 1);
+        int ry = 1 + rng() % (h - rh - 1);
+        for (int y = ry; y < ry+rh; ++y)
+            for (int x = rx; x < rx+rw; ++x)
+                rows[y][x] = '.';
+        room_centers.emplace_back(rx+rw/2, ry+rh/2);
     }
-    // If not found, forcibly carve a path
-    if (!found) {
-        // Simple straight tunnel
-        int x = sx, y = sy;
-        while (x != gx || y != gy) {
-            if (x < gx) ++x;
-            else if (x > gx) --x;
-            else if (y < gy) ++y;
-            else if (y > gy) --y;
-            if (map[y][x] == '#') map[y][x] = '.';
+    // 2. Maze/hallways using randomized DFS from first room center. Maze
+    // cells share the start's parity, so they are tracked at half resolution
+    // (cell (x >> 1, y >> 1)), a byte each with a ring of extra cells around
+    // them: visited in the top bit (cells outside the maze start out
+    // visited), then the cell's try order and the direction that led to it,
+    // which is both the way back and the passage carved into it. The map is
+    // only written once the maze is done. Tried directions are all visited,
+    // so the next one to try is the first unvisited one in the cell's order,
+    // straight from a table.
+    {
+        const int px = room_centers[0].first & 1, py = room_centers[0].second & 1;
+        const int cw = (w + 1) / 2, ch = (h + 1) / 2, stride = cw + 2;
+        const uint8_t VISITED = 0x80;
+        std::vector<uint8_t> cells((size_t)stride * (ch + 2), 0);
+        auto at = [stride](int cx, int cy) { return (size_t)(cy + 1) * stride + cx + 1; };
+        for (int cy = -1; cy <= ch; ++cy) {
+            const int y = cy * 2 + py;
+            const bool outside = y <= 0 || y >= h-1;
+            for (int cx = -1; cx <= cw && (outside || cx * 2 + px <= 0); ++cx)
+                cells[at(cx, cy)] = VISITED;
+            for (int cx = cw; cx >= -1 && (outside || cx * 2 + px >= w-1); --cx)
+                cells[at(cx, cy)] = VISITED;
+        }
+        static const MazeOrders orders;
+        const ptrdiff_t step[4] = {-stride, 1, stride, -1};
+        // The step to the next cell, 0 for none: one load less between a
+        // cell and the next than looking up the direction and then its step
+        ptrdiff_t move[24][16];
+        for (int n = 0; n < 24; ++n)
+            for (int mask = 0; mask < 16; ++mask)
+                move[n][mask] = orders.first_open[n][mask] < 4 ? step[orders.first_open[n][mask]] : 0;
+        const size_t start = at(room_centers[0].first >> 1, room_centers[0].second >> 1);
+        size_t c = start;
+        cells[c] = (uint8_t)(VISITED | MazeOrders::draw(rng) << 2);
+        for (;;) {
+            const unsigned cell = cells[c], order = cell >> 2 & 31;
+            unsigned open = 0;
+            for (int d = 0; d < 4; ++d)
+                open |= (unsigned)(cells[c + step[d]] >> 7 ^ 1) << d;
+            if (move[order][open] == 0) {
+                if (c == start)
+                    break;
+                c -= step[cell & 3];
+                continue;
+            }
+            c += move[order][open];
+            cells[c] = (uint8_t)(VISITED | MazeOrders::draw(rng) << 2 | orders.first_open[order][open]);
+        }
+        // Every maze cell was visited; open it and the passage into it
+        for (int y = py; y < h; y += 2) {
+            if (y <= 0 || y >= h-1)
+                continue;
+            for (int x = px; x < w; x += 2) {
+                if (x <= 0 || x >= w-1)
+                    continue;
+                const size_t i = at(x >> 1, y >> 1);
+                rows[y][x] = '.';
+                if (i != start)
+                    rows[y - dy[cells[i] & 3]][x - dx[cells[i] & 3]] = '.';
+            }
         }
     }
+    // 3. Doorways, joined to the maze (which reaches every room)
+    finish_floor(map, rng, entrance_pos, exit_pos, stats, true);
+    if (stats)
+        stats->rooms = num_rooms;
     return map;
 }
+
+namespace {
+struct FloorStyleEntry {
+    const char* name;
+    FloorGenerator generate;
+};
+const FloorStyleEntry floor_styles[FLOOR_STYLE_COUNT] = {
+    {"maze", generate_random_floor},
+    {"caves", generate_cave_floor},
+    {"halls", generate_hall_floor},
+};
+} // namespace
+
+FloorGenerator floor_generator(FloorStyle style) {
+    return floor_styles[(int)style].generate;
+}
+
+const char* floor_style_name(FloorStyle style) {
+    return floor_styles[(int)style].name;
+}
+
+bool parse_floor_styles(const char* list, std::vector<FloorStyle>& styles) {
+    styles.clear();
+    for (const char* p = list;;) {
+        const char* end = strchr(p, ',');
+        const size_t len = end ? (size_t)(end - p) : strlen(p);
+        int i = 0;
+        while (i < FLOOR_STYLE_COUNT && (strlen(floor_styles[i].name) != len || strncmp(p, floor_styles[i].name, len) != 0))
+            ++i;
+        if (i == FLOOR_STYLE_COUNT)
+            return false;
+        styles.push_back((FloorStyle)i);
+        if (!end)
+            return true;
+        p = end + 1;
+    }
+}
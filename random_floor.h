@@ -1,9 +1,79 @@
 #pragma once
+#include <cstdint>
+#include <random>
 #include <vector>
 #include <string>
 #include <utility>
 
-// Generates a random floor with a guaranteed path from entrance to exit.
+// What the generator did, for tuning (see tools/floorgen.cpp)
+struct FloorGenStats {
+    int rooms = 0;
+    int areas = 0;  // separate areas of floor before they were joined
+    int carved = 0; // walls knocked down to join them
+};
+
+// Generates a random floor with a guaranteed path from entrance to exit;
+// every floor tile (rooms included) can be reached from the entrance.
 // entrance_pos and exit_pos will be set to the generated positions.
-// Returns a vector of strings representing the map.
-std::vector<std::string> generate_random_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed = 0);
+// Returns a vector of strings representing the map. Seed 0 picks a random
+// seed; stats, if given, is filled in.
+std::vector<std::string> generate_random_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed = 0, FloorGenStats* stats = nullptr);
+
+// Other floor styles, with the same contract as generate_random_floor().
+// Caves smooths random noise into caverns (a cellular automaton over
+// bit-packed rows); it has no rooms to count.
+std::vector<std::string> generate_cave_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed = 0, FloorGenStats* stats = nullptr);
+// Halls splits the floor into rectangles (binary space partition), puts a
+// room in each and links sibling rooms with corridors
+std::vector<std::string> generate_hall_floor(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed = 0, FloorGenStats* stats = nullptr);
+
+// Floor styles, one generator each
+enum class FloorStyle { Maze, Caves, Halls };
+constexpr int FLOOR_STYLE_COUNT = 3;
+using FloorGenerator = std::vector<std::string> (*)(int w, int h, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, unsigned int seed, FloorGenStats* stats);
+FloorGenerator floor_generator(FloorStyle style);
+// "maze", "caves", "halls"
+const char* floor_style_name(FloorStyle style);
+// Reads comma-separated style names; false on an unknown one
+bool parse_floor_styles(const char* list, std::vector<FloorStyle>& styles);
+
+// The numbers std::mt19937 gives for the same seed, made 624 at a time (the
+// state twisted with SSE2 where available, then tempered into a buffer)
+// instead of one per call. Generators draw from it, so a seed still makes the
+// floor std::mt19937 made of it.
+class FloorRng {
+public:
+    using result_type = std::mt19937::result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+    explicit FloorRng(uint32_t seed);
+    result_type operator()() {
+        if (next_ == N)
+            refill();
+        return out_[next_++];
+    }
+
+private:
+    static const int N = 624, M = 397;
+    void refill();
+    uint32_t state_[N], out_[N];
+    int next_ = N;
+};
+
+// A fast random stream for generator backends: seed state once (from their
+// FloorRng), then each call returns 64 random bits
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// The last step of every generator: puts the entrance and exit on the outer
+// wall (apart, not in corners) with floor inside them, then joins every area
+// of floor into one (the largest, or the entrance's when no smaller), so
+// every floor tile and the exit can be reached from the entrance. The map
+// must be walled all round. Fills in the positions and stats->areas / carved.
+// Pass connected when the generator's floor is one area already: then only
+// the tiles inside the doorways are joined to it, without labelling the map.
+void finish_floor(std::vector<std::string>& map, FloorRng& rng, std::pair<int,int>& entrance_pos, std::pair<int,int>& exit_pos, FloorGenStats* stats, bool connected = false);
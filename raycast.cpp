@@ -0,0 +1,288 @@
+#include "raycast.h"
+#include "level.h"
+#include <cmath>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+Camera make_camera(const Player& player) {
+    Camera cam;
+    float fov = M_PI / 3.0f; // 60 degrees
+    cam.pos_x = player.x + 0.5f;
+    cam.pos_y = player.y + 0.5f;
+    // Cardinal directions: 0=N,1=E,2=S,3=W
+    switch (player.dir) {
+    case 1:  cam.dir_x = 1;  cam.dir_y = 0;  break;
+    case 2:  cam.dir_x = 0;  cam.dir_y = 1;  break;
+    case 3:  cam.dir_x = -1; cam.dir_y = 0;  break;
+    default: cam.dir_x = 0;  cam.dir_y = -1; break;
+    }
+    // Camera plane perpendicular to dir
+    cam.plane_x = -cam.dir_y * tanf(fov / 2);
+    cam.plane_y = cam.dir_x * tanf(fov / 2);
+    return cam;
+}
+
+void cast_column(const Camera& cam, int x, int view_w, int tex_w, RayHit& hit) {
+    float cam_x = 2.0f * x / view_w - 1.0f;
+    float ray_dir_x = cam.dir_x + cam.plane_x * cam_x;
+    float ray_dir_y = cam.dir_y + cam.plane_y * cam_x;
+    int map_x = (int)cam.pos_x;
+    int map_y = (int)cam.pos_y;
+    float side_dist_x, side_dist_y;
+    float delta_dist_x = (ray_dir_x == 0) ? 1e30 : fabs(1.0f / ray_dir_x);
+    float delta_dist_y = (ray_dir_y == 0) ? 1e30 : fabs(1.0f / ray_dir_y);
+    int step_x, step_y;
+    int side = 0;
+    // Calculate step and initial sideDist
+    if (ray_dir_x < 0) {
+        step_x = -1;
+        side_dist_x = (cam.pos_x - map_x) * delta_dist_x;
+    } else {
+        step_x = 1;
+        side_dist_x = (map_x + 1.0f - cam.pos_x) * delta_dist_x;
+    }
+    if (ray_dir_y < 0) {
+        step_y = -1;
+        side_dist_y = (cam.pos_y - map_y) * delta_dist_y;
+    } else {
+        step_y = 1;
+        side_dist_y = (map_y + 1.0f - cam.pos_y) * delta_dist_y;
+    }
+    // Perform DDA
+    char tile;
+    for (;;) {
+        if (side_dist_x < side_dist_y) {
+            side_dist_x += delta_dist_x;
+            map_x += step_x;
+            side = 0;
+        } else {
+            side_dist_y += delta_dist_y;
+            map_y += step_y;
+            side = 1;
+        }
+        // The map's wall border stops every ray, so this never leaves it
+        tile = get_tile_unchecked(map_x, map_y);
+        if (is_solid(tile))
+            break;
+    }
+    // Calculate distance to wall
+    float perp_wall_dist = side == 0 ? side_dist_x - delta_dist_x : side_dist_y - delta_dist_y;
+    // Texture X coordinate from the wall hit location
+    float wall_x = side == 0 ? cam.pos_y + perp_wall_dist * ray_dir_y
+                             : cam.pos_x + perp_wall_dist * ray_dir_x;
+    wall_x -= floorf(wall_x);
+    int tex_x = int(wall_x * tex_w);
+    if ((side == 0 && ray_dir_x > 0) || (side == 1 && ray_dir_y < 0))
+        tex_x = tex_w - tex_x - 1;
+
+    hit.perp_wall_dist = perp_wall_dist;
+    hit.side = side;
+    hit.map_x = map_x;
+    hit.map_y = map_y;
+    hit.tile = tile;
+    hit.tex_x = tex_x;
+}
+
+void cast_columns_scalar(const Camera& cam, int x0, int x1, int view_w, int tex_w, RayHit* hits) {
+    for (int x = x0; x < x1; ++x)
+        cast_column(cam, x, view_w, tex_w, hits[x]);
+}
+
+#if defined(__SSE2__)
+// Packet DDA: traces V::N adjacent columns together. Each lane performs the
+// same float operations in the same order as cast_column, so the results are
+// bit-identical; lanes that have hit a wall are masked out of further steps.
+// Note: raycast.cpp is built with -ffp-contract=off so that neither path
+// gets FMA-contracted differently from the other.
+
+// SSE2, 4 lanes
+struct Lanes4 {
+    typedef __m128 F;
+    typedef __m128i I;
+    static constexpr int N = 4;
+    static F set1(float v) { return _mm_set1_ps(v); }
+    static I set1_i(int v) { return _mm_set1_epi32(v); }
+    static I lane_index() { return _mm_setr_epi32(0, 1, 2, 3); }
+    static I lane_bit() { return _mm_setr_epi32(1, 2, 4, 8); }
+    static F to_f(I v) { return _mm_cvtepi32_ps(v); }
+    static I trunc_i(F v) { return _mm_cvttps_epi32(v); }
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm_div_ps(a, b); }
+    static F abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static F lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+    static F gt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+    static F eq(F a, F b) { return _mm_cmpeq_ps(a, b); }
+    static F and_(F a, F b) { return _mm_and_ps(a, b); }
+    static F andnot(F a, F b) { return _mm_andnot_ps(a, b); } // ~a & b
+    static F or_(F a, F b) { return _mm_or_ps(a, b); }
+    static F select(F m, F t, F f) { return _mm_or_ps(_mm_and_ps(m, t), _mm_andnot_ps(m, f)); }
+    static I add_i(I a, I b) { return _mm_add_epi32(a, b); }
+    static I sub_i(I a, I b) { return _mm_sub_epi32(a, b); }
+    static F eq_i(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+    static I and_i(I a, I b) { return _mm_and_si128(a, b); }
+    static I select_i(F m, I t, I f) {
+        __m128i mi = _mm_castps_si128(m);
+        return _mm_or_si128(_mm_and_si128(mi, t), _mm_andnot_si128(mi, f));
+    }
+    static int movemask(F m) { return _mm_movemask_ps(m); }
+    static void store_i(int* out, I v) { _mm_storeu_si128((__m128i*)out, v); }
+    static void store(float* out, F v) { _mm_storeu_ps(out, v); }
+    // Tiles under each lane (no 32-bit multiply or gather in SSE2)
+    static I load_tiles(I map_x, I map_y) {
+        alignas(16) int mx[N], my[N];
+        store_i(mx, map_x);
+        store_i(my, map_y);
+        return _mm_setr_epi32(get_tile_unchecked(mx[0], my[0]), get_tile_unchecked(mx[1], my[1]),
+                              get_tile_unchecked(mx[2], my[2]), get_tile_unchecked(mx[3], my[3]));
+    }
+};
+
+#if defined(__AVX2__)
+// AVX2, 8 lanes
+struct Lanes8 {
+    typedef __m256 F;
+    typedef __m256i I;
+    static constexpr int N = 8;
+    static F set1(float v) { return _mm256_set1_ps(v); }
+    static I set1_i(int v) { return _mm256_set1_epi32(v); }
+    static I lane_index() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+    static I lane_bit() { return _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128); }
+    static F to_f(I v) { return _mm256_cvtepi32_ps(v); }
+    static I trunc_i(F v) { return _mm256_cvttps_epi32(v); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm256_div_ps(a, b); }
+    static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static F lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static F gt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static F eq(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static F and_(F a, F b) { return _mm256_and_ps(a, b); }
+    static F andnot(F a, F b) { return _mm256_andnot_ps(a, b); }
+    static F or_(F a, F b) { return _mm256_or_ps(a, b); }
+    static F select(F m, F t, F f) { return _mm256_blendv_ps(f, t, m); }
+    static I add_i(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I sub_i(I a, I b) { return _mm256_sub_epi32(a, b); }
+    static F eq_i(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+    static I and_i(I a, I b) { return _mm256_and_si256(a, b); }
+    static I select_i(F m, I t, I f) { return _mm256_blendv_epi8(f, t, _mm256_castps_si256(m)); }
+    static int movemask(F m) { return _mm256_movemask_ps(m); }
+    static void store_i(int* out, I v) { _mm256_storeu_si256((__m256i*)out, v); }
+    static void store(float* out, F v) { _mm256_storeu_ps(out, v); }
+    // Tiles under each lane: one gather of 4 bytes per lane from the padded
+    // grid (level.cpp keeps slack after the last tile), low byte kept
+    static I load_tiles(I map_x, I map_y) {
+        I idx = _mm256_add_epi32(_mm256_mullo_epi32(map_y, _mm256_set1_epi32(level_stride)), map_x);
+        I raw = _mm256_i32gather_epi32((const int*)level_tiles, idx, 1);
+        return _mm256_and_si256(raw, _mm256_set1_epi32(0xff));
+    }
+};
+typedef Lanes8 PacketLanes;
+#else
+typedef Lanes4 PacketLanes;
+#endif
+
+template <class V>
+static void cast_packet(const Camera& cam, int x, int view_w, int tex_w, RayHit* hits) {
+    typedef typename V::F F;
+    typedef typename V::I I;
+    constexpr int N = V::N;
+    const F zero = V::set1(0.0f);
+
+    F cam_x = V::sub(V::div(V::mul(V::set1(2.0f), V::to_f(V::add_i(V::set1_i(x), V::lane_index()))),
+                            V::set1((float)view_w)),
+                     V::set1(1.0f));
+    F ray_dir_x = V::add(V::set1(cam.dir_x), V::mul(V::set1(cam.plane_x), cam_x));
+    F ray_dir_y = V::add(V::set1(cam.dir_y), V::mul(V::set1(cam.plane_y), cam_x));
+    int map_x0 = (int)cam.pos_x;
+    int map_y0 = (int)cam.pos_y;
+    F delta_dist_x = V::select(V::eq(ray_dir_x, zero), V::set1(1e30f),
+                               V::abs(V::div(V::set1(1.0f), ray_dir_x)));
+    F delta_dist_y = V::select(V::eq(ray_dir_y, zero), V::set1(1e30f),
+                               V::abs(V::div(V::set1(1.0f), ray_dir_y)));
+    F neg_x = V::lt(ray_dir_x, zero);
+    F neg_y = V::lt(ray_dir_y, zero);
+    I step_x = V::select_i(neg_x, V::set1_i(-1), V::set1_i(1));
+    I step_y = V::select_i(neg_y, V::set1_i(-1), V::set1_i(1));
+    F side_dist_x = V::mul(V::select(neg_x, V::set1(cam.pos_x - map_x0), V::set1(map_x0 + 1.0f - cam.pos_x)),
+                           delta_dist_x);
+    F side_dist_y = V::mul(V::select(neg_y, V::set1(cam.pos_y - map_y0), V::set1(map_y0 + 1.0f - cam.pos_y)),
+                           delta_dist_y);
+
+    // Masked DDA: every lane steps until it hits, finished lanes hold still
+    I map_x = V::set1_i(map_x0);
+    I map_y = V::set1_i(map_y0);
+    I side = V::set1_i(0);
+    const I lane_bit = V::lane_bit();
+    const int all_done = (1 << N) - 1;
+    int done = 0;
+    I tile = V::set1_i(0);
+    while (done != all_done) {
+        F active = V::eq_i(V::and_i(lane_bit, V::set1_i(done)), V::set1_i(0));
+        F step_in_x = V::lt(side_dist_x, side_dist_y);
+        F move_x = V::and_(active, step_in_x);
+        F move_y = V::andnot(step_in_x, active);
+        side_dist_x = V::select(move_x, V::add(side_dist_x, delta_dist_x), side_dist_x);
+        side_dist_y = V::select(move_y, V::add(side_dist_y, delta_dist_y), side_dist_y);
+        map_x = V::select_i(move_x, V::add_i(map_x, step_x), map_x);
+        map_y = V::select_i(move_y, V::add_i(map_y, step_y), map_y);
+        side = V::select_i(move_x, V::set1_i(0), V::select_i(move_y, V::set1_i(1), side));
+        // Finished lanes sit on their wall, so loading under every lane
+        // stays inside the border
+        I t = V::load_tiles(map_x, map_y);
+        F stopped = V::and_(active, V::or_(V::eq_i(t, V::set1_i(TILE_WALL)),
+                                           V::or_(V::eq_i(t, V::set1_i(TILE_ENTRANCE)),
+                                                  V::eq_i(t, V::set1_i(TILE_EXIT)))));
+        tile = V::select_i(stopped, t, tile);
+        done |= V::movemask(stopped);
+    }
+
+    F side0 = V::eq_i(side, V::set1_i(0));
+    F perp_wall_dist = V::select(side0, V::sub(side_dist_x, delta_dist_x), V::sub(side_dist_y, delta_dist_y));
+    F wall_x = V::select(side0, V::add(V::set1(cam.pos_y), V::mul(perp_wall_dist, ray_dir_y)),
+                         V::add(V::set1(cam.pos_x), V::mul(perp_wall_dist, ray_dir_x)));
+    // floorf() without SSE4.1: truncate, then fix up negative fractions
+    F t = V::to_f(V::trunc_i(wall_x));
+    t = V::sub(t, V::and_(V::gt(t, wall_x), V::set1(1.0f)));
+    wall_x = V::sub(wall_x, t);
+    I tex_x = V::trunc_i(V::mul(wall_x, V::set1((float)tex_w)));
+    F flip = V::or_(V::and_(side0, V::gt(ray_dir_x, zero)), V::andnot(side0, V::lt(ray_dir_y, zero)));
+    tex_x = V::select_i(flip, V::sub_i(V::set1_i(tex_w - 1), tex_x), tex_x);
+
+    alignas(32) float dist[N];
+    alignas(32) int sides[N], tx[N], mx[N], my[N], tiles[N];
+    V::store(dist, perp_wall_dist);
+    V::store_i(sides, side);
+    V::store_i(tx, tex_x);
+    V::store_i(mx, map_x);
+    V::store_i(my, map_y);
+    V::store_i(tiles, tile);
+    for (int lane = 0; lane < N; ++lane) {
+        RayHit& hit = hits[x + lane];
+        hit.perp_wall_dist = dist[lane];
+        hit.side = sides[lane];
+        hit.map_x = mx[lane];
+        hit.map_y = my[lane];
+        hit.tile = (char)tiles[lane];
+        hit.tex_x = tx[lane];
+    }
+}
+
+int raycast_packet_width() { return PacketLanes::N; }
+
+void cast_columns(const Camera& cam, int x0, int x1, int view_w, int tex_w, RayHit* hits) {
+    int x = x0;
+    for (; x + PacketLanes::N <= x1; x += PacketLanes::N)
+        cast_packet<PacketLanes>(cam, x, view_w, tex_w, hits);
+    cast_columns_scalar(cam, x, x1, view_w, tex_w, hits);
+}
+#else
+int raycast_packet_width() { return 1; }
+
+void cast_columns(const Camera& cam, int x0, int x1, int view_w, int tex_w, RayHit* hits) {
+    cast_columns_scalar(cam, x0, x1, view_w, tex_w, hits);
+}
+#endif
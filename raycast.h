@@ -0,0 +1,33 @@
+#pragma once
+#include "player.h"
+
+// Camera basis for the player's pose (tile center, cardinal facing)
+struct Camera {
+    float pos_x, pos_y;
+    float dir_x, dir_y;
+    float plane_x, plane_y;
+};
+
+// Result of tracing one screen column
+struct RayHit {
+    float perp_wall_dist; // distance to the wall along the view direction
+    int side;             // 0 = hit an x-side, 1 = hit a y-side
+    int map_x, map_y;     // tile that stopped the ray
+    char tile;
+    int tex_x;            // wall texture column (for a texture tex_w wide)
+};
+
+Camera make_camera(const Player& player);
+
+// Traces screen column x of a view_w wide view
+void cast_column(const Camera& cam, int x, int view_w, int tex_w, RayHit& hit);
+
+// Traces columns [x0, x1) into hits[x0..x1), packets of adjacent columns at
+// a time (SSE2: 4, AVX2: 8); bit-identical to calling cast_column per column
+void cast_columns(const Camera& cam, int x0, int x1, int view_w, int tex_w, RayHit* hits);
+
+// Reference path: one cast_column per column
+void cast_columns_scalar(const Camera& cam, int x0, int x1, int view_w, int tex_w, RayHit* hits);
+
+// Columns traced per packet by cast_columns (1 when built without SSE2)
+int raycast_packet_width();
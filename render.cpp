@@ -1,38 +1,141 @@
 #include "render.h"
 #include "level.h"
 #include "player.h"
+#include "raycast.h"
+#include "column_cache.h"
+#include "floorcast.h"
+#include "sprites.h"
+#include "framebuffer.h"
+#include "text.h"
+#include "engine/workers.h"
+#include "engine/assetpack.h"
+#include "engine/profile_sdl.h"
+#include "engine/log.h"
 #include <SDL.h>
 #include <SDL_image.h>
 #include <algorithm>
 #include <cmath>
-#include <iostream>
+#include <cstring>
 #include <string>
+#include <vector>
 
 // Global texture pointers
 SDL_Texture *g_wall_tex = nullptr;
 SDL_Texture *g_floor_tex = nullptr;
 SDL_Texture *g_item_tex = nullptr;
 
-// Load textures from assets/
-bool load_dungeon_textures(SDL_Renderer *ren) {
-  auto load_tex = [&](const char *path) -> SDL_Texture * {
-    SDL_Surface *surf = IMG_Load(path);
-    if (!surf) {
-      std::cerr << "IMG_Load failed: " << path << " - " << IMG_GetError()
-                << std::endl;
+RenderPath g_render_path = RenderPath::Renderer;
+
+// CPU copies of the dungeon textures for the framebuffer path
+static PixelImage g_wall_px, g_floor_px, g_item_px;
+
+static Framebuffer g_view_fb;
+
+// Floor and ceiling for the current pose. Like the wall columns they only
+// change when the player moves or turns, so they are cast once per pose.
+static Framebuffer g_planes;
+static int g_planes_x = -1, g_planes_y = -1, g_planes_dir = -1;
+static bool g_planes_uploaded = false;
+static ColumnCache g_columns;
+static std::vector<float> g_zbuf; // wall distance per column, for sprites
+
+// Sprite images. There is no monster art yet: monsters use item.png tinted
+// red unless assets/monster.png exists.
+static SDL_Texture *g_monster_tex = nullptr;
+static PixelImage g_monster_px;
+static SpriteImage g_item_img, g_monster_img;
+static std::vector<std::pair<int, int>> g_item_queue;
+static const RayHit *g_hits = nullptr; // this frame's hits, one per column
+
+// Images come from the asset pack (assets/moravor.pak, built by
+// moravor_pack) when it exists: pixels are already ARGB8888, so textures are
+// filled straight from the mapped file and the CPU images point into it.
+// Without a pack, the loose PNGs are decoded and converted.
+static const char *const ASSET_PACK_PATH = "assets/moravor.pak";
+static bool g_pack_tried = false;
+
+static bool find_packed(const char *path, engine::PackImage &out) {
+  if (!g_pack_tried) {
+    g_pack_tried = true;
+    if (engine::open_asset_pack(ASSET_PACK_PATH))
+      LOG_DEBUG(Assets, "Using asset pack %s", ASSET_PACK_PATH);
+  }
+  const char *slash = strrchr(path, '/');
+  return engine::find_pack_image(slash ? slash + 1 : path, out);
+}
+
+bool image_available(const char *path) {
+  engine::PackImage packed;
+  if (find_packed(path, packed))
+    return true;
+  SDL_RWops *rw = SDL_RWFromFile(path, "rb");
+  if (!rw)
+    return false;
+  SDL_RWclose(rw);
+  return true;
+}
+
+SDL_Texture *load_image_texture(SDL_Renderer *ren, const char *path, PixelImage *img) {
+  engine::PackImage packed;
+  if (find_packed(path, packed)) {
+    SDL_Texture *tex = engine::prof_create_texture(ren, SDL_PIXELFORMAT_ARGB8888,
+                                                   SDL_TEXTUREACCESS_STATIC, packed.w, packed.h);
+    if (!tex) {
+      LOG_ERROR(Assets, "SDL_CreateTexture failed: %s - %s", path, SDL_GetError());
       return nullptr;
     }
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(ren, surf);
-    SDL_FreeSurface(surf);
-    if (!tex) {
-      std::cerr << "SDL_CreateTextureFromSurface failed: " << path << " - "
-                << SDL_GetError() << std::endl;
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(tex, nullptr, packed.pixels, packed.pitch * (int)sizeof(Uint32));
+    if (img) {
+      img->w = packed.w;
+      img->h = packed.h;
+      img->pitch = packed.pitch;
+      img->px = packed.pixels;
+      img->storage.clear();
     }
     return tex;
-  };
-  g_wall_tex = load_tex("assets/wall.png");
-  g_floor_tex = load_tex("assets/floor.png");
-  g_item_tex = load_tex("assets/item.png");
+  }
+  SDL_Surface *surf = IMG_Load(path);
+  if (!surf) {
+    LOG_ERROR(Assets, "IMG_Load failed: %s - %s", path, IMG_GetError());
+    return nullptr;
+  }
+  if (img) {
+    SDL_Surface *argb =
+        SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (argb) {
+      img->w = argb->w;
+      img->h = argb->h;
+      img->pitch = argb->w;
+      img->storage.resize((size_t)argb->w * argb->h);
+      for (int y = 0; y < argb->h; ++y)
+        memcpy(&img->storage[(size_t)y * argb->w],
+               (const Uint8 *)argb->pixels + y * argb->pitch,
+               argb->w * sizeof(Uint32));
+      img->px = img->storage.data();
+      SDL_FreeSurface(argb);
+    }
+  }
+  SDL_Texture *tex = engine::prof_create_texture_from_surface(ren, surf);
+  SDL_FreeSurface(surf);
+  if (!tex) {
+    LOG_ERROR(Assets, "SDL_CreateTextureFromSurface failed: %s - %s", path, SDL_GetError());
+  }
+  return tex;
+}
+
+// Load textures from assets/
+bool load_dungeon_textures(SDL_Renderer *ren) {
+  g_wall_tex = load_image_texture(ren, "assets/wall.png", &g_wall_px);
+  g_floor_tex = load_image_texture(ren, "assets/floor.png", &g_floor_px);
+  g_item_tex = load_image_texture(ren, "assets/item.png", &g_item_px);
+  g_item_img = {g_item_tex, &g_item_px, {255, 255, 255, 255}};
+  if (image_available("assets/monster.png"))
+    g_monster_tex = load_image_texture(ren, "assets/monster.png", &g_monster_px);
+  if (g_monster_tex)
+    g_monster_img = {g_monster_tex, &g_monster_px, {255, 255, 255, 255}};
+  else
+    g_monster_img = {g_item_tex, &g_item_px, {255, 80, 80, 255}};
   return g_wall_tex && g_floor_tex && g_item_tex;
 }
 
@@ -46,465 +149,675 @@ void free_dungeon_textures() {
   if (g_item_tex)
     SDL_DestroyTexture(g_item_tex);
   g_item_tex = nullptr;
+  if (g_monster_tex)
+    SDL_DestroyTexture(g_monster_tex);
+  g_monster_tex = nullptr;
+  g_wall_px = PixelImage();
+  g_floor_px = PixelImage();
+  g_item_px = PixelImage();
+  g_monster_px = PixelImage();
+  g_item_img = SpriteImage();
+  g_monster_img = SpriteImage();
+  framebuffer_free(g_view_fb);
+  framebuffer_free(g_planes);
+  g_planes_dir = -1;
+  column_cache_clear(g_columns);
+  // The CPU images above pointed into the mapped pack
+  engine::close_asset_pack();
+  g_pack_tried = false;
 }
 
-// Raycasting-based dungeon renderer (Wolfenstein style)
-void render_dungeon(SDL_Renderer *ren, const Player &player, const Monster* monster, int win_w,
-                    int top_h, int /*bottom_h*/) {
-  // Colors
-  SDL_Color ceil = {0, 0, 60, 255}; // Darker blue
-
-  // Fill background (ceiling)
-  SDL_SetRenderDrawColor(ren, ceil.r, ceil.g, ceil.b, ceil.a);
-  SDL_Rect rect = {0, 0, win_w, top_h / 2};
-  SDL_RenderFillRect(ren, &rect);
-  // Fill floor with texture (repeat)
-  if (g_floor_tex) {
-    int tex_w, tex_h;
-    SDL_QueryTexture(g_floor_tex, nullptr, nullptr, &tex_w, &tex_h);
-    for (int x = 0; x < win_w; x += tex_w) {
-      for (int y = top_h / 2; y < top_h; y += tex_h) {
-        SDL_Rect dst = {x, y, tex_w, tex_h};
-        SDL_RenderCopy(ren, g_floor_tex, nullptr, &dst);
-      }
+// Height of the wall slice for a hit, and its clamped [start, end) rows
+static inline void wall_span(const RayHit &hit, int top_h, int &line_height,
+                             int &draw_start, int &draw_end) {
+  line_height = (int)(top_h / (hit.perp_wall_dist + 1e-6));
+  draw_start = -line_height / 2 + top_h / 2;
+  draw_end = line_height / 2 + top_h / 2;
+  // Clamp to ceiling/floor bounds
+  if (draw_start < 0)
+    draw_start = 0;
+  if (draw_end > top_h)
+    draw_end = top_h;
+}
+
+// Draws the view with one renderer call per column
+static void draw_view_renderer(SDL_Renderer *ren, int win_w, int top_h) {
+  if (g_planes.tex) {
+    // Cast floor and ceiling, uploaded only when the pose changed
+    if (!g_planes_uploaded) {
+      framebuffer_upload(g_planes);
+      g_planes_uploaded = true;
     }
+    SDL_Rect view = {0, 0, win_w, top_h};
+    engine::prof_render_copy(ren, g_planes.tex, nullptr, &view);
   } else {
+    SDL_SetRenderDrawColor(ren, 0, 0, 60, 255); // Darker blue
+    SDL_Rect rect = {0, 0, win_w, top_h / 2};
+    engine::prof_render_fill_rect(ren, &rect);
     SDL_SetRenderDrawColor(ren, 30, 30, 60, 255);
-    rect = {0, top_h / 2, win_w, top_h / 2};
-    SDL_RenderFillRect(ren, &rect);
+    rect = {0, top_h / 2, win_w, top_h - top_h / 2};
+    engine::prof_render_fill_rect(ren, &rect);
   }
 
-  // Raycasting parameters
-  float fov = M_PI / 3.0f; // 60 degrees
-  float cam_x, ray_dir_x, ray_dir_y;
-  float pos_x = player.x + 0.5f;
-  float pos_y = player.y + 0.5f;
-  float dir_x, dir_y;
-  // Cardinal directions: 0=N,1=E,2=S,3=W
-  switch (player.dir) {
-  case 0:
-    dir_x = 0;
-    dir_y = -1;
-    break;
-  case 1:
-    dir_x = 1;
-    dir_y = 0;
-    break;
-  case 2:
-    dir_x = 0;
-    dir_y = 1;
-    break;
-  case 3:
-    dir_x = -1;
-    dir_y = 0;
-    break;
-  default:
-    dir_x = 0;
-    dir_y = -1;
-    break;
-  }
-  // Camera plane perpendicular to dir
-  float plane_x = -dir_y * tanf(fov / 2);
-  float plane_y = dir_x * tanf(fov / 2);
-
+  int tex_w = 0, tex_h = 0;
+  if (g_wall_tex)
+    SDL_QueryTexture(g_wall_tex, nullptr, nullptr, &tex_w, &tex_h);
   for (int x = 0; x < win_w; ++x) {
-    cam_x = 2.0f * x / win_w - 1.0f;
-    ray_dir_x = dir_x + plane_x * cam_x;
-    ray_dir_y = dir_y + plane_y * cam_x;
-    int map_x = (int)pos_x;
-    int map_y = (int)pos_y;
-    float side_dist_x, side_dist_y;
-    float delta_dist_x = (ray_dir_x == 0) ? 1e30 : fabs(1.0f / ray_dir_x);
-    float delta_dist_y = (ray_dir_y == 0) ? 1e30 : fabs(1.0f / ray_dir_y);
-    float perp_wall_dist;
-    int step_x, step_y;
-    int hit = 0, side = 0;
-    // Calculate step and initial sideDist
-    if (ray_dir_x < 0) {
-      step_x = -1;
-      side_dist_x = (pos_x - map_x) * delta_dist_x;
-    } else {
-      step_x = 1;
-      side_dist_x = (map_x + 1.0f - pos_x) * delta_dist_x;
-    }
-    if (ray_dir_y < 0) {
-      step_y = -1;
-      side_dist_y = (pos_y - map_y) * delta_dist_y;
-    } else {
-      step_y = 1;
-      side_dist_y = (map_y + 1.0f - pos_y) * delta_dist_y;
-    }
-    // Perform DDA
-    while (!hit) {
-      if (side_dist_x < side_dist_y) {
-        side_dist_x += delta_dist_x;
-        map_x += step_x;
-        side = 0;
-      } else {
-        side_dist_y += delta_dist_y;
-        map_y += step_y;
-        side = 1;
-      }
-      char tile = get_tile(map_x, map_y);
-      if (tile == TILE_WALL || tile == TILE_ENTRANCE || tile == TILE_EXIT)
-        hit = 1;
-    }
-    // Calculate distance to wall
-    if (side == 0)
-      perp_wall_dist = (side_dist_x - delta_dist_x);
-    else
-      perp_wall_dist = (side_dist_y - delta_dist_y);
-    // Calculate height of line to draw
-    int line_height = (int)(top_h / (perp_wall_dist + 1e-6));
-    int draw_start = -line_height / 2 + top_h / 2;
-    int draw_end = line_height / 2 + top_h / 2;
-    // Clamp to ceiling/floor bounds
-    if (draw_start < 0)
-      draw_start = 0;
-    if (draw_end > top_h)
-      draw_end = top_h;
+    const RayHit &hit = g_hits[x];
+    int line_height, draw_start, draw_end;
+    wall_span(hit, top_h, line_height, draw_start, draw_end);
     // Draw the vertical wall slice
-    char tile = get_tile(map_x, map_y);
-    if (tile == TILE_ENTRANCE) {
-        SDL_SetRenderDrawColor(ren, 20, 80, 20, 255); // green
-        SDL_RenderDrawLine(ren, x, draw_start, x, draw_end);
-    } else if (tile == TILE_EXIT) {
-        SDL_SetRenderDrawColor(ren, 80, 20, 30, 255); // maroon
-        SDL_RenderDrawLine(ren, x, draw_start, x, draw_end);
-    } else if (g_wall_tex && tile == TILE_WALL) {
-      int tex_w, tex_h;
-      SDL_QueryTexture(g_wall_tex, nullptr, nullptr, &tex_w, &tex_h);
-      // Calculate texture X coordinate (simple, based on wall hit location)
-      float wall_x;
-      if (side == 0)
-        wall_x = pos_y + perp_wall_dist * ray_dir_y;
-      else
-        wall_x = pos_x + perp_wall_dist * ray_dir_x;
-      wall_x -= floorf(wall_x);
-      int tex_x = int(wall_x * tex_w);
-      if ((side == 0 && ray_dir_x > 0) || (side == 1 && ray_dir_y < 0))
-        tex_x = tex_w - tex_x - 1;
-      SDL_Rect src = {tex_x, 0, 1, tex_h};
+    if (hit.tile == TILE_ENTRANCE) {
+      SDL_SetRenderDrawColor(ren, 20, 80, 20, 255); // green
+      engine::prof_render_draw_line(ren, x, draw_start, x, draw_end);
+    } else if (hit.tile == TILE_EXIT) {
+      SDL_SetRenderDrawColor(ren, 80, 20, 30, 255); // maroon
+      engine::prof_render_draw_line(ren, x, draw_start, x, draw_end);
+    } else if (g_wall_tex && hit.tile == TILE_WALL) {
+      SDL_Rect src = {hit.tex_x, 0, 1, tex_h};
       SDL_Rect dst = {x, draw_start, 1, draw_end - draw_start};
-      SDL_RenderCopy(ren, g_wall_tex, &src, &dst);
+      engine::prof_render_copy(ren, g_wall_tex, &src, &dst);
     } else {
       SDL_SetRenderDrawColor(ren, 180, 180, 180, 255);
-      SDL_RenderDrawLine(ren, x, draw_start, x, draw_end);
+      engine::prof_render_draw_line(ren, x, draw_start, x, draw_end);
     }
   }
+}
 
-  // Line of sight check using Bresenham's algorithm
-  auto has_line_of_sight = [](int x0, int y0, int x1, int y1) {
-    int dx = abs(x1 - x0), dy = abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
-    while (x0 != x1 || y0 != y1) {
-      if (x0 == x1 && y0 == y1)
-        break;
-      if (x0 != x1 || y0 != y1) {
-        if (level_data[y0][x0] == TILE_WALL)
-          return false;
-      }
-      int e2 = 2 * err;
-      if (e2 > -dy) {
-        err -= dy;
-        x0 += sx;
-      }
-      if (e2 < dx) {
-        err += dx;
-        y0 += sy;
-      }
-    }
-    return true;
-  };
+// Framebuffer colors (ARGB8888)
+static const Uint32 FB_CEIL = 0xFF00003C;  // Darker blue
+static const Uint32 FB_FLOOR = 0xFF1E1E3C; // Used when floor.png is missing
+static const Uint32 FB_ENTRANCE = 0xFF145014, FB_EXIT = 0xFF50141E;
+static const Uint32 FB_PLAIN_WALL = 0xFFB4B4B4;
 
-  // Classic raycasting sprite rendering for objects (Wolfenstein/Doom style)
-  struct Sprite {
-    SDL_Texture *tex;
-    float obj_x, obj_y; // world position
-    float dist;
-  };
-  std::vector<Sprite> sprites;
-  // Compute distance from player for sorting
-  for (auto &s : sprites) {
-    float dx = s.obj_x - pos_x;
-    float dy = s.obj_y - pos_y;
-    s.dist = dx * dx + dy * dy;
+// Background for rows [y0, y1): the cached floor/ceiling, or flat colors
+static void fill_view_rows(Framebuffer &fb, int y0, int y1) {
+  int horizon = fb.h / 2;
+  for (int y = y0; y < y1; ++y) {
+    Uint32 *row = fb.pixels.data() + (size_t)y * fb.w;
+    if (g_planes.w == fb.w && g_planes.h == fb.h)
+      memcpy(row, &g_planes.pixels[(size_t)y * fb.w], fb.w * sizeof(Uint32));
+    else
+      std::fill(row, row + fb.w, y < horizon ? FB_CEIL : FB_FLOOR);
   }
-  // Sort farthest to nearest
-  std::sort(sprites.begin(), sprites.end(),
-            [](const Sprite &a, const Sprite &b) { return a.dist > b.dist; });
-  // Camera vectors
-  // Use existing cam_x, cam_y, cam_dir_x, cam_dir_y, plane_x, plane_y
-  // For each sprite
-  for (const auto &s : sprites) {
-    // Only render if player has line of sight to the sprite's tile
-    if (!has_line_of_sight(player.x, player.y, int(s.obj_x), int(s.obj_y)))
-      continue;
-    // Use a robust threshold for 'same tile' (within 0.3 units)
-    // Special rendering for same-tile objects: much larger than one-tile-away,
-    // base-aligned
-    if (std::abs(s.obj_x - pos_x) < 0.3f && std::abs(s.obj_y - pos_y) < 0.3f) {
-      // Make the sprite extremely large for same-tile
-      int tile_sprite_h = int(top_h * 6.0f);
-      int tile_sprite_w = tile_sprite_h;
-      int tile_draw_start_y = top_h - tile_sprite_h;
-      // Clamp only if needed, always keep base at bottom
-      if (tile_draw_start_y < 0) {
-        tile_sprite_h += tile_draw_start_y; // reduce height
-        tile_sprite_w = tile_sprite_h;
-        tile_draw_start_y = 0;
+}
+
+// Re-casts the floor and ceiling when the pose or the view size changed
+static void update_planes(SDL_Renderer *ren, const Player &player, const Camera &cam,
+                          int win_w, int top_h) {
+  if (g_floor_px.w <= 0)
+    return;
+  if (g_planes.w == win_w && g_planes.h == top_h && g_planes_x == player.x &&
+      g_planes_y == player.y && g_planes_dir == player.dir)
+    return;
+  if (!framebuffer_resize(g_planes, ren, win_w, top_h))
+    return;
+  g_planes_x = player.x;
+  g_planes_y = player.y;
+  g_planes_dir = player.dir;
+  g_planes_uploaded = false;
+  engine::parallel_for(0, top_h, 1, [&](int y0, int y1) {
+    cast_plane_rows(cam, g_planes.pixels.data(), win_w, top_h, y0, y1,
+                    g_floor_px.px, g_floor_px.w, g_floor_px.h, g_floor_px.pitch);
+  });
+}
+
+// Wall slices for columns [x0, x1)
+static void draw_wall_columns(Framebuffer &fb, int x0, int x1) {
+  Uint32 *px = fb.pixels.data();
+  const int pitch = fb.w, top_h = fb.h;
+  const bool wall_tex = g_wall_px.w > 0;
+  for (int x = x0; x < x1; ++x) {
+    const RayHit &hit = g_hits[x];
+    int line_height, draw_start, draw_end;
+    wall_span(hit, top_h, line_height, draw_start, draw_end);
+    Uint32 *dst = px + (size_t)draw_start * pitch + x;
+    if (wall_tex && hit.tile == TILE_WALL && line_height > 0) {
+      // Step through the texture column in 16.16 fixed point
+      const Uint32 *col = g_wall_px.px + hit.tex_x;
+      int tex_h = g_wall_px.h;
+      int64_t step = ((int64_t)tex_h << 16) / line_height;
+      int64_t tex_pos = (int64_t)(draw_start - (top_h / 2 - line_height / 2)) * step;
+      for (int y = draw_start; y < draw_end; ++y, dst += pitch) {
+        int tex_y = (int)(tex_pos >> 16);
+        if (tex_y >= tex_h)
+          tex_y = tex_h - 1;
+        *dst = col[(size_t)tex_y * g_wall_px.pitch];
+        tex_pos += step;
       }
-      int tile_draw_start_x = (win_w - tile_sprite_w) / 2;
-      SDL_Rect dst = {tile_draw_start_x, tile_draw_start_y, tile_sprite_w,
-                      tile_sprite_h};
-      if (dst.h > 0 && dst.w > 0)
-        SDL_RenderCopy(ren, s.tex, nullptr, &dst);
-      continue;
-    }
-    // Classic projection for remote tiles
-    float rel_x = s.obj_x - pos_x;
-    float rel_y = s.obj_y - pos_y;
-    // Transform to camera space
-    float inv_det = 1.0f / (plane_x * dir_y - dir_x * plane_y);
-    float trans_x = inv_det * (dir_y * rel_x - dir_x * rel_y);
-    float trans_y = inv_det * (-plane_y * rel_x + plane_x * rel_y);
-    if (trans_y <= 0)
-      continue; // behind camera
-    // Projected screen position
-    int sprite_screen_x = int((win_w / 2) * (1 + trans_x / trans_y));
-    // Projected height
-    int sprite_h = abs(int(top_h / trans_y));
-    int sprite_w = sprite_h;
-    int draw_start_x = sprite_screen_x - sprite_w / 2;
-    int draw_start_y = (top_h - sprite_h) / 2;
-    SDL_Rect dst = {draw_start_x, draw_start_y, sprite_w, sprite_h};
-    // Clamp to main view
-    if (dst.y < 0) {
-      dst.h += dst.y;
-      dst.y = 0;
-    }
-    if (dst.y + dst.h > top_h)
-      dst.h = top_h - dst.y;
-    if (dst.x < 0) {
-      dst.w += dst.x;
-      dst.x = 0;
+    } else {
+      Uint32 c = hit.tile == TILE_ENTRANCE ? FB_ENTRANCE
+                 : hit.tile == TILE_EXIT   ? FB_EXIT
+                                           : FB_PLAIN_WALL;
+      for (int y = draw_start; y < draw_end; ++y, dst += pitch)
+        *dst = c;
     }
-    if (dst.x + dst.w > win_w)
-      dst.w = win_w - dst.x;
-    if (dst.h > 0 && dst.w > 0)
-      SDL_RenderCopy(ren, s.tex, nullptr, &dst);
+  }
+}
+
+// Draws the background and walls into g_view_fb (uploaded after sprites)
+static bool draw_view_framebuffer(SDL_Renderer *ren, int win_w, int top_h) {
+  if (!framebuffer_resize(g_view_fb, ren, win_w, top_h))
+    return false;
+  engine::parallel_for(0, top_h, 1, [](int y0, int y1) {
+    fill_view_rows(g_view_fb, y0, y1);
+  });
+  engine::parallel_for(0, win_w, 1, [](int x0, int x1) {
+    draw_wall_columns(g_view_fb, x0, x1);
+  });
+  return true;
+}
+
+static void queue_sprites(const Monster *monsters, int monster_count) {
+  sprites_clear();
+  for (int i = 0; i < monster_count; ++i)
+    if (monsters[i].state != MonsterState::Dead)
+      sprites_add(monsters[i].x + 0.5f, monsters[i].y + 0.5f, &g_monster_img);
+  for (const auto &item : g_item_queue)
+    sprites_add(item.first + 0.5f, item.second + 0.5f, &g_item_img);
+  g_item_queue.clear();
+}
+
+void queue_item_sprite(int x, int y) { g_item_queue.emplace_back(x, y); }
+
+// Raycasting-based dungeon renderer (Wolfenstein style)
+void render_dungeon(SDL_Renderer *ren, const Player &player, const Monster *monsters,
+                    int monster_count, int win_w, int top_h, int /*bottom_h*/) {
+  if (win_w <= 0 || top_h <= 0)
+    return;
+  Camera cam = make_camera(player);
+
+  int tex_w = 1;
+  if (g_render_path == RenderPath::Framebuffer && g_wall_px.w > 0)
+    tex_w = g_wall_px.w;
+  else if (g_wall_tex)
+    SDL_QueryTexture(g_wall_tex, nullptr, nullptr, &tex_w, nullptr);
+  // Column strips are traced on the worker pool only when the pose or the
+  // map changed; a standing player reuses last frame's hits
+  PROFILE_BEGIN(cast_zone, "cast columns");
+  g_hits = column_cache_update(g_columns, player, cam, win_w, tex_w);
+  PROFILE_END(cast_zone);
+  PROFILE_BEGIN(planes_zone, "cast planes");
+  update_planes(ren, player, cam, win_w, top_h);
+  PROFILE_END(planes_zone);
+  // Per-column depth buffer for the sprite stage
+  g_zbuf.resize(win_w);
+  for (int x = 0; x < win_w; ++x)
+    g_zbuf[x] = g_hits[x].perp_wall_dist;
+
+  queue_sprites(monsters, monster_count);
+  if (g_render_path == RenderPath::Framebuffer) {
+    PROFILE_BEGIN(walls_zone, "draw walls");
+    if (!draw_view_framebuffer(ren, win_w, top_h))
+      return;
+    PROFILE_END(walls_zone);
+    PROFILE_BEGIN(sprites_zone, "draw sprites");
+    sprites_draw(ren, &g_view_fb, cam, g_zbuf.data(), win_w, top_h);
+    PROFILE_END(sprites_zone);
+    PROFILE_ZONE("upload view");
+    SDL_Rect view = {0, 0, win_w, top_h};
+    framebuffer_present(g_view_fb, ren, &view);
+  } else {
+    PROFILE_BEGIN(walls_zone, "draw walls");
+    draw_view_renderer(ren, win_w, top_h);
+    PROFILE_END(walls_zone);
+    PROFILE_ZONE("draw sprites");
+    sprites_draw(ren, nullptr, cam, g_zbuf.data(), win_w, top_h);
   }
 }
 
 // Draws party/status area under the window
 SDL_Rect g_attack_btn_rects[3];
 
+// Bottom area layout: 4 equal squares (left 3 = party, right = minimap)
+struct PanelLayout {
+  int margin, area_y, square_w, square_h;
+};
+
+static PanelLayout panel_layout(int win_w, int top_h, int bottom_h) {
+  PanelLayout l;
+  l.margin = 8;
+  l.area_y = top_h + l.margin;
+  l.square_w = (win_w - 2 * l.margin) / 4;
+  l.square_h = bottom_h - 2 * l.margin;
+  return l;
+}
+
+// Attack button of a party box whose top-left corner is (box_x, box_y)
+static SDL_Rect attack_btn_rect(int box_x, int box_y, const PanelLayout &l) {
+  SDL_Rect inner = {box_x + 8, box_y + 8, l.square_w - 16, l.square_h - 16};
+  int btn_h = 32;
+  return {inner.x + 8, inner.y + inner.h - btn_h - 8, inner.w - 16, btn_h};
+}
+
+// Draws one square of the panel at box; member is null for empty slots and
+// for the minimap square
+static void draw_panel_box(SDL_Renderer *ren, const SDL_Rect &box, const Player *member,
+                           bool party_slot, TTF_Font *font, const PanelLayout &l) {
+  SDL_SetRenderDrawColor(ren, 220, 220, 220, 255);
+  engine::prof_render_fill_rect(ren, &box);
+  SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+  engine::prof_render_draw_rect(ren, &box);
+  if (!party_slot)
+    return; // The minimap square is filled in by render_minimap
+  SDL_Rect inner = {box.x + 8, box.y + 8, box.w - 16, box.h - 16};
+  if (!member) {
+    SDL_SetRenderDrawColor(ren, 200, 200, 200, 255);
+    engine::prof_render_fill_rect(ren, &inner);
+    SDL_SetRenderDrawColor(ren, 120, 120, 120, 255);
+    engine::prof_render_draw_rect(ren, &inner);
+    return;
+  }
+  SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
+  engine::prof_render_fill_rect(ren, &inner);
+  SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+  engine::prof_render_draw_rect(ren, &inner);
+  const Player &p = *member;
+  SDL_Color fg = {0, 0, 0, 255};
+  int text_x = inner.x + 8;
+  int text_y = inner.y + 8;
+  int line_h = 22;
+  // Name
+  draw_text(ren, font, p.name.c_str(), text_x, text_y, fg);
+  text_y += line_h;
+  // Stats: HP, AT, DF, AG (one per row)
+  char statbuf[32];
+  snprintf(statbuf, sizeof(statbuf), "HP %d/%d", p.hp, p.max_hp);
+  draw_text(ren, font, statbuf, text_x, text_y, fg);
+  text_y += line_h;
+  snprintf(statbuf, sizeof(statbuf), "AT %d", p.attack);
+  draw_text(ren, font, statbuf, text_x, text_y, fg);
+  text_y += line_h;
+  snprintf(statbuf, sizeof(statbuf), "DF %d", p.defense);
+  draw_text(ren, font, statbuf, text_x, text_y, fg);
+  text_y += line_h;
+  snprintf(statbuf, sizeof(statbuf), "AG %d", p.agility);
+  draw_text(ren, font, statbuf, text_x, text_y, fg);
+  // Attack button
+  SDL_Rect btn_rect = attack_btn_rect(box.x, box.y, l);
+  SDL_SetRenderDrawColor(ren, 200, 80, 80, 255);
+  engine::prof_render_fill_rect(ren, &btn_rect);
+  SDL_SetRenderDrawColor(ren, 60, 0, 0, 255);
+  engine::prof_render_draw_rect(ren, &btn_rect);
+  draw_text_centered(ren, font, "Attack", btn_rect, fg);
+}
+
+// Retained panel: each party slot is drawn into its own render target and
+// only redrawn when that member's stats change; the slots and the minimap
+// square are composited into one HUD texture, copied once per frame
+struct PanelSlot {
+  SDL_Texture *tex = nullptr;
+  bool valid = false;
+  bool occupied = false;
+  Player shown; // stats the texture was drawn with
+};
+static PanelSlot g_panel_slots[3];
+static SDL_Texture *g_hud_tex = nullptr;
+static int g_hud_w = 0, g_hud_h = 0;
+static bool g_hud_valid = false;
+static TTF_Font *g_hud_font = nullptr;
+
+static bool same_stats(const Player &a, const Player &b) {
+  return a.hp == b.hp && a.max_hp == b.max_hp && a.attack == b.attack &&
+         a.defense == b.defense && a.agility == b.agility && a.name == b.name;
+}
+
+static SDL_Texture *create_target(SDL_Renderer *ren, int w, int h) {
+  SDL_Texture *tex = engine::prof_create_texture(ren, SDL_PIXELFORMAT_ARGB8888,
+                                                 SDL_TEXTUREACCESS_TARGET, w, h);
+  if (tex)
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+  return tex;
+}
+
+void invalidate_party_panel() {
+  for (PanelSlot &slot : g_panel_slots)
+    slot.valid = false;
+  g_hud_valid = false;
+}
+
+void free_party_panel() {
+  for (PanelSlot &slot : g_panel_slots) {
+    if (slot.tex)
+      SDL_DestroyTexture(slot.tex);
+    slot = PanelSlot();
+  }
+  if (g_hud_tex)
+    SDL_DestroyTexture(g_hud_tex);
+  g_hud_tex = nullptr;
+  g_hud_w = g_hud_h = 0;
+  g_hud_valid = false;
+}
+
+// Immediate-mode fallback when render targets are unavailable
+static void draw_party_status_direct(SDL_Renderer *ren, const Party &party, TTF_Font *font,
+                                     const PanelLayout &l) {
+  for (int i = 0; i < 4; ++i) {
+    SDL_Rect box = {l.margin + i * l.square_w, l.area_y, l.square_w, l.square_h};
+    const Player *member = i < party.count ? &party.members[i] : nullptr;
+    draw_panel_box(ren, box, member, i < 3, font, l);
+  }
+}
+
 void render_party_status(SDL_Renderer* ren, const Party& party, TTF_Font* font, int win_w, int top_h, int bottom_h) {
-    // Split the bottom area into 4 equal squares (left 3 = party, right = minimap)
-    int margin = 8;
-    int area_y = top_h + margin;
-    int area_h = bottom_h - 2 * margin;
-    int square_w = (win_w - 2 * margin) / 4;
-    int square_h = area_h;
-
-    for (int i = 0; i < 4; ++i) {
-        int x = margin + i * square_w;
-        SDL_Rect box = {x, area_y, square_w, square_h};
-        SDL_SetRenderDrawColor(ren, 220, 220, 220, 255);
-        SDL_RenderFillRect(ren, &box);
-        SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
-        SDL_RenderDrawRect(ren, &box);
-        if (i < 3) {
-            // Character panels
-            if (i < party.count) {
-                SDL_Rect inner = {box.x + 8, box.y + 8, box.w - 16, box.h - 16};
-                SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
-                SDL_RenderFillRect(ren, &inner);
-                SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
-                SDL_RenderDrawRect(ren, &inner);
-                const Player& p = party.members[i];
-                SDL_Color fg = {0,0,0,255};
-                int text_x = inner.x + 8;
-                int text_y = inner.y + 8;
-                int line_h = 22;
-                // Name
-                SDL_Surface* surf = TTF_RenderUTF8_Blended(font, p.name.c_str(), fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        SDL_Rect dst = {text_x, text_y, surf->w, surf->h};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    text_y += line_h;
-                    SDL_FreeSurface(surf);
-                }
-                // Stats: HP, AT, DF, AG (one per row)
-                char statbuf[32];
-                snprintf(statbuf, sizeof(statbuf), "HP %d/%d", p.hp, p.max_hp);
-                surf = TTF_RenderUTF8_Blended(font, statbuf, fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        SDL_Rect dst = {text_x, text_y, surf->w, surf->h};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    text_y += line_h;
-                    SDL_FreeSurface(surf);
-                }
-                snprintf(statbuf, sizeof(statbuf), "AT %d", p.attack);
-                surf = TTF_RenderUTF8_Blended(font, statbuf, fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        SDL_Rect dst = {text_x, text_y, surf->w, surf->h};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    text_y += line_h;
-                    SDL_FreeSurface(surf);
-                }
-                snprintf(statbuf, sizeof(statbuf), "DF %d", p.defense);
-                surf = TTF_RenderUTF8_Blended(font, statbuf, fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        SDL_Rect dst = {text_x, text_y, surf->w, surf->h};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    text_y += line_h;
-                    SDL_FreeSurface(surf);
-                }
-                snprintf(statbuf, sizeof(statbuf), "AG %d", p.agility);
-                surf = TTF_RenderUTF8_Blended(font, statbuf, fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        SDL_Rect dst = {text_x, text_y, surf->w, surf->h};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    text_y += line_h;
-                    SDL_FreeSurface(surf);
-                }
-                // Draw Attack button
-                int btn_w = inner.w - 16;
-                int btn_h = 32;
-                int btn_x = inner.x + 8;
-                int btn_y = inner.y + inner.h - btn_h - 8;
-                SDL_Rect btn_rect = {btn_x, btn_y, btn_w, btn_h};
-                g_attack_btn_rects[i] = btn_rect;
-                SDL_SetRenderDrawColor(ren, 200, 80, 80, 255);
-                SDL_RenderFillRect(ren, &btn_rect);
-                SDL_SetRenderDrawColor(ren, 60, 0, 0, 255);
-                SDL_RenderDrawRect(ren, &btn_rect);
-                // Button label
-                const char* attack_label = "Attack";
-                surf = TTF_RenderUTF8_Blended(font, attack_label, fg);
-                if (surf) {
-                    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                    if (tex) {
-                        SDL_Rect dst = {btn_x + (btn_w-surf->w)/2, btn_y + (btn_h-surf->h)/2, surf->w, surf->h};
-                        SDL_RenderCopy(ren, tex, nullptr, &dst);
-                        SDL_DestroyTexture(tex);
-                    }
-                    SDL_FreeSurface(surf);
-                }
-            } else {
-                SDL_Rect inner = {box.x + 8, box.y + 8, box.w - 16, box.h - 16};
-                SDL_SetRenderDrawColor(ren, 200, 200, 200, 255);
-                SDL_RenderFillRect(ren, &inner);
-                SDL_SetRenderDrawColor(ren, 120, 120, 120, 255);
-                SDL_RenderDrawRect(ren, &inner);
-                g_attack_btn_rects[i] = {0,0,0,0}; // No button for empty slot
-            }
-        }
-        // The 4th (rightmost) square is reserved for the minimap (drawn elsewhere)
+  PanelLayout l = panel_layout(win_w, top_h, bottom_h);
+  // Hit-test rects stay in window coordinates, whether or not we redraw
+  for (int i = 0; i < 3; ++i)
+    g_attack_btn_rects[i] = i < party.count
+                                ? attack_btn_rect(l.margin + i * l.square_w, l.area_y, l)
+                                : SDL_Rect{0, 0, 0, 0}; // No button for empty slot
+  if (l.square_w <= 0 || l.square_h <= 0)
+    return;
+
+  // Window size or font change: new targets, everything redraws
+  if (g_hud_w != 4 * l.square_w || g_hud_h != l.square_h || g_hud_font != font) {
+    free_party_panel();
+    g_hud_w = 4 * l.square_w;
+    g_hud_h = l.square_h;
+    g_hud_font = font;
+    g_hud_tex = create_target(ren, g_hud_w, g_hud_h);
+    for (PanelSlot &slot : g_panel_slots)
+      slot.tex = create_target(ren, l.square_w, l.square_h);
+  }
+  bool targets = g_hud_tex;
+  for (PanelSlot &slot : g_panel_slots)
+    targets = targets && slot.tex;
+  if (!targets) {
+    draw_party_status_direct(ren, party, font, l);
+    return;
+  }
+
+  SDL_Texture *prev_target = SDL_GetRenderTarget(ren);
+  // Box-local layout: slot textures are drawn with their corner at (0, 0)
+  PanelLayout local = l;
+  local.margin = 0;
+  local.area_y = 0;
+  for (int i = 0; i < 3; ++i) {
+    PanelSlot &slot = g_panel_slots[i];
+    bool occupied = i < party.count;
+    if (slot.valid && slot.occupied == occupied &&
+        (!occupied || same_stats(slot.shown, party.members[i])))
+      continue;
+    SDL_SetRenderTarget(ren, slot.tex);
+    SDL_Rect box = {0, 0, l.square_w, l.square_h};
+    draw_panel_box(ren, box, occupied ? &party.members[i] : nullptr, true, font, local);
+    slot.valid = true;
+    slot.occupied = occupied;
+    if (occupied)
+      slot.shown = party.members[i];
+    g_hud_valid = false;
+  }
+  if (!g_hud_valid) {
+    SDL_SetRenderTarget(ren, g_hud_tex);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
+    engine::prof_render_clear(ren);
+    for (int i = 0; i < 3; ++i) {
+      SDL_Rect dst = {i * l.square_w, 0, l.square_w, l.square_h};
+      engine::prof_render_copy(ren, g_panel_slots[i].tex, nullptr, &dst);
     }
+    // The 4th (rightmost) square is reserved for the minimap (drawn elsewhere)
+    SDL_Rect box = {3 * l.square_w, 0, l.square_w, l.square_h};
+    draw_panel_box(ren, box, nullptr, false, font, local);
+    g_hud_valid = true;
+  }
+  SDL_SetRenderTarget(ren, prev_target);
+
+  SDL_Rect dst = {l.margin, l.area_y, g_hud_w, g_hud_h};
+  engine::prof_render_copy(ren, g_hud_tex, nullptr, &dst);
 }
 
 
 
 // Minimap overlay in rightmost bottom square
-#include "main.cpp" // for floors and get_current_floor
-
-void render_minimap(SDL_Renderer *ren, const Player &player, int win_w,
-                    int top_h, int bottom_h)
-{
-    int margin = 8;
-    int area_y = top_h + margin;
-    int area_h = bottom_h - 2 * margin;
-    int square_w = (win_w - 2 * margin) / 4;
-    int x0 = margin + 3 * square_w;
-    int y0 = area_y;
-    int map_w = square_w;
-    int map_h = area_h;
-    int cell_w = map_w / MAP_W;
-    int cell_h = map_h / MAP_H;
-
-    // --- TEMP: Place monster on map as 'M' ---
-    char orig = 0;
-    int cf = get_current_floor();
-    if (cf >= 0 && cf < (int)floors.size()) {
-        const Monster& m = floors[cf].monster;
-        if (m.state != MonsterState::Dead) {
-            orig = level_data[m.y][m.x];
-            level_data[m.y][m.x] = 'M';
-        }
-    }
+//
+// The static tile layer lives in a texture with one texel per tile, or per
+// 2^k x 2^k block of tiles for maps larger than the minimap square (a
+// pyramid of downsampled levels, the coarsest one that fits is shown). It is
+// rebuilt when the map is replaced and patched texel by texel for edited
+// tiles. The player and monsters are drawn on top and never touch map data.
+enum MinimapClass : Uint8 { MM_FLOOR, MM_WALL, MM_ENTRANCE, MM_EXIT };
 
-    // Draw minimap background
-    SDL_SetRenderDrawColor(ren, 30, 30, 30, 220);
-    SDL_Rect bg = {x0, y0, map_w, map_h};
-    SDL_RenderFillRect(ren, &bg);
-    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
-    SDL_RenderDrawRect(ren, &bg);
-
-    // Draw map tiles
-    for (int j = 0; j < MAP_H; ++j) {
-        for (int i = 0; i < MAP_W; ++i) {
-            SDL_Rect cell = {x0 + i * cell_w, y0 + j * cell_h, cell_w - 1, cell_h - 1};
-            if (level_data[j][i] == TILE_WALL) {
-                SDL_SetRenderDrawColor(ren, 80, 80, 80, 255);
-            } else if (level_data[j][i] == TILE_ENTRANCE) {
-                SDL_SetRenderDrawColor(ren, 20, 80, 20, 255);
-            } else if (level_data[j][i] == TILE_EXIT) {
-        SDL_SetRenderDrawColor(ren, 80, 20, 30, 255);
-    }
-    // Draw player
-    int px = x0 + int((player.x + 0.5f) * cell_w);
-    int py = y0 + int((player.y + 0.5f) * cell_h);
-    SDL_SetRenderDrawColor(ren, 255, 255, 0, 255);
-    SDL_Rect pcell = {px - 3, py - 3, 6, 6};
-    SDL_RenderFillRect(ren, &pcell);
-    // Draw facing direction
-    float dx = 0, dy = 0;
-    switch (player.dir) {
-    case 0:
-        dy = -1;
-        break;
-    case 1:
-        dx = 1;
-        break;
-    case 2:
-        dy = 1;
-        break;
-    case 3:
-        dx = -1;
-        break;
-    }
-    int fx = px + int(dx * 10), fy = py + int(dy * 10);
-    SDL_RenderDrawLine(ren, px, py, fx, fy);
-
-    // --- Restore monster tile ---
-    if (cf >= 0 && cf < (int)floors.size()) {
-        const Monster& m = floors[cf].monster;
-        if (m.state != MonsterState::Dead && orig) {
-            level_data[m.y][m.x] = orig;
-        }
-    }
+struct MinimapLayer {
+  unsigned level_version = 0;
+  size_t changes_seen = 0;
+  int map_w = 0, map_h = 0;
+  int max_w = 0, max_h = 0; // texel budget (minimap square size)
+  std::vector<std::vector<Uint8>> levels; // levels[k]: classes at 1/2^k
+  std::vector<int> level_w, level_h;
+  SDL_Texture *tex = nullptr;
+};
+static MinimapLayer g_minimap;
+
+static Uint8 minimap_class(char tile) {
+  switch (tile) {
+  case TILE_WALL:
+    return MM_WALL;
+  case TILE_ENTRANCE:
+    return MM_ENTRANCE;
+  case TILE_EXIT:
+    return MM_EXIT;
+  default:
+    return MM_FLOOR;
+  }
+}
+
+static Uint32 minimap_texel(Uint8 c) {
+  switch (c) {
+  case MM_WALL:
+    return 0xFF505050;
+  case MM_ENTRANCE:
+    return 0xFF145014;
+  case MM_EXIT:
+    return 0xFF50141E;
+  default:
+    return 0x00000000; // floor: background shows through
+  }
+}
+
+// Downsampled texel k at (x, y): doors win over walls, walls over floor
+static Uint8 minimap_reduce(const MinimapLayer &m, int k, int x, int y) {
+  const std::vector<Uint8> &src = m.levels[k - 1];
+  int sw = m.level_w[k - 1], sh = m.level_h[k - 1];
+  Uint8 c = MM_FLOOR;
+  for (int j = 2 * y; j < std::min(2 * y + 2, sh); ++j)
+    for (int i = 2 * x; i < std::min(2 * x + 2, sw); ++i)
+      c = std::max(c, src[(size_t)j * sw + i]);
+  return c;
+}
+
+static void minimap_upload_texel(MinimapLayer &m, int x, int y) {
+  int top = (int)m.levels.size() - 1;
+  Uint32 texel = minimap_texel(m.levels[top][(size_t)y * m.level_w[top] + x]);
+  SDL_Rect r = {x, y, 1, 1};
+  SDL_UpdateTexture(m.tex, &r, &texel, sizeof(Uint32));
+}
+
+static void minimap_rebuild(MinimapLayer &m, SDL_Renderer *ren, int max_w, int max_h) {
+  if (m.tex)
+    SDL_DestroyTexture(m.tex);
+  m.tex = nullptr;
+  m.map_w = MAP_W;
+  m.map_h = MAP_H;
+  m.max_w = max_w;
+  m.max_h = max_h;
+  m.level_version = get_level_version();
+  m.changes_seen = get_tile_changes().size();
+  m.levels.assign(1, std::vector<Uint8>((size_t)MAP_W * MAP_H));
+  m.level_w.assign(1, MAP_W);
+  m.level_h.assign(1, MAP_H);
+  for (int y = 0; y < MAP_H; ++y)
+    for (int x = 0; x < MAP_W; ++x)
+      m.levels[0][(size_t)y * MAP_W + x] = minimap_class(get_tile_unchecked(x, y));
+  // Halve until the level fits in the minimap square
+  while ((m.level_w.back() > max_w || m.level_h.back() > max_h) &&
+         (m.level_w.back() > 1 || m.level_h.back() > 1)) {
+    int k = (int)m.levels.size();
+    int w = (m.level_w.back() + 1) / 2, h = (m.level_h.back() + 1) / 2;
+    m.level_w.push_back(w);
+    m.level_h.push_back(h);
+    m.levels.emplace_back((size_t)w * h);
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+        m.levels[k][(size_t)y * w + x] = minimap_reduce(m, k, x, y);
+  }
+  int top = (int)m.levels.size() - 1;
+  int w = m.level_w[top], h = m.level_h[top];
+  std::vector<Uint32> texels((size_t)w * h);
+  for (size_t i = 0; i < texels.size(); ++i)
+    texels[i] = minimap_texel(m.levels[top][i]);
+  m.tex = engine::prof_create_texture(ren, SDL_PIXELFORMAT_ARGB8888,
+                                      SDL_TEXTUREACCESS_STATIC, w, h);
+  if (!m.tex) {
+    LOG_ERROR(Render, "SDL_CreateTexture failed for minimap: %s", SDL_GetError());
+    return;
+  }
+  SDL_SetTextureBlendMode(m.tex, SDL_BLENDMODE_BLEND);
+  SDL_UpdateTexture(m.tex, nullptr, texels.data(), w * (int)sizeof(Uint32));
+}
+
+// Re-derives one edited tile up the pyramid and patches its texel
+static void minimap_update_tile(MinimapLayer &m, int x, int y) {
+  if (x < 0 || x >= m.map_w || y < 0 || y >= m.map_h)
+    return;
+  m.levels[0][(size_t)y * m.map_w + x] = minimap_class(get_tile(x, y));
+  for (int k = 1; k < (int)m.levels.size(); ++k) {
+    x >>= 1;
+    y >>= 1;
+    m.levels[k][(size_t)y * m.level_w[k] + x] = minimap_reduce(m, k, x, y);
+  }
+  minimap_upload_texel(m, x, y);
+}
+
+void free_minimap() {
+  if (g_minimap.tex)
+    SDL_DestroyTexture(g_minimap.tex);
+  g_minimap = MinimapLayer();
+}
+
+void render_minimap(SDL_Renderer *ren, const Player &player,
+                    const Monster *monsters, int monster_count, int win_w,
+                    int top_h, int bottom_h) {
+  PanelLayout l = panel_layout(win_w, top_h, bottom_h);
+  int x0 = l.margin + 3 * l.square_w;
+  int y0 = l.area_y;
+  int map_w = l.square_w;
+  int map_h = l.square_h;
+  if (map_w <= 0 || map_h <= 0 || MAP_W <= 0 || MAP_H <= 0)
+    return;
+
+  // Bring the tile layer up to date
+  MinimapLayer &m = g_minimap;
+  const std::vector<std::pair<int, int>> &changes = get_tile_changes();
+  if (!m.tex || m.level_version != get_level_version() || m.map_w != MAP_W ||
+      m.map_h != MAP_H || m.max_w != map_w || m.max_h != map_h ||
+      m.changes_seen > changes.size()) {
+    minimap_rebuild(m, ren, map_w, map_h);
+  } else {
+    for (size_t i = m.changes_seen; i < changes.size(); ++i)
+      minimap_update_tile(m, changes[i].first, changes[i].second);
+    m.changes_seen = changes.size();
+  }
+
+  // Draw minimap background
+  SDL_SetRenderDrawColor(ren, 30, 30, 30, 220);
+  SDL_Rect bg = {x0, y0, map_w, map_h};
+  engine::prof_render_fill_rect(ren, &bg);
+  SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+  engine::prof_render_draw_rect(ren, &bg);
+
+  // Draw map tiles: whole texels per cell, like the old per-tile rects
+  int top = (int)m.levels.size() - 1;
+  int tw = m.level_w[top], th = m.level_h[top];
+  int cell_w = std::max(1, map_w / tw), cell_h = std::max(1, map_h / th);
+  SDL_Rect map_dst = {x0, y0, tw * cell_w, th * cell_h};
+  if (m.tex)
+    engine::prof_render_copy(ren, m.tex, nullptr, &map_dst);
+  // Screen position of a tile center
+  float scale_x = (float)map_dst.w / MAP_W, scale_y = (float)map_dst.h / MAP_H;
+  auto to_screen = [&](int tx, int ty, int &sx, int &sy) {
+    sx = x0 + int((tx + 0.5f) * scale_x);
+    sy = y0 + int((ty + 0.5f) * scale_y);
+  };
+
+  // Entity overlay
+  SDL_SetRenderDrawColor(ren, 200, 40, 40, 255);
+  for (int i = 0; i < monster_count; ++i) {
+    if (monsters[i].state == MonsterState::Dead)
+      continue;
+    int mx, my;
+    to_screen(monsters[i].x, monsters[i].y, mx, my);
+    SDL_Rect mcell = {mx - 2, my - 2, 5, 5};
+    engine::prof_render_fill_rect(ren, &mcell);
+  }
+  // Draw player
+  int px, py;
+  to_screen(player.x, player.y, px, py);
+  SDL_SetRenderDrawColor(ren, 255, 255, 0, 255);
+  SDL_Rect pcell = {px - 3, py - 3, 6, 6};
+  engine::prof_render_fill_rect(ren, &pcell);
+  // Draw facing direction
+  float dx = 0, dy = 0;
+  switch (player.dir) {
+  case 0:
+    dy = -1;
+    break;
+  case 1:
+    dx = 1;
+    break;
+  case 2:
+    dy = 1;
+    break;
+  case 3:
+    dx = -1;
+    break;
+  }
+  int fx = px + int(dx * 10), fy = py + int(dy * 10);
+  engine::prof_render_draw_line(ren, px, py, fx, fy);
+}
+
+// Profiler overlay: frame time graph (last PROFILE_HISTORY frames, full
+// height = 33 ms, line at 16.7 ms) and the last frame's stages and counters
+void render_profiler_overlay(SDL_Renderer *ren, TTF_Font *font, int win_w, int /*win_h*/) {
+  const engine::ProfileFrames &f = engine::profiler_frames();
+  const int graph_h = 60, pad = 6, line_h = font ? TTF_FontHeight(font) : 0;
+  const int rows = 2 + (int)f.stages.size();
+  SDL_Rect box = {win_w - engine::PROFILE_HISTORY - 2 * pad - 8, 8,
+                  engine::PROFILE_HISTORY + 2 * pad, graph_h + 3 * pad + rows * line_h};
+  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor(ren, 0, 0, 0, 180);
+  engine::prof_render_fill_rect(ren, &box);
+  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+
+  const int gx = box.x + pad, gy = box.y + pad;
+  static SDL_Rect bars[engine::PROFILE_HISTORY];
+  float total = 0.0f;
+  for (int i = 0; i < f.count; ++i) {
+    float ms = f.frame_ms[(f.head + i) % engine::PROFILE_HISTORY];
+    total += ms;
+    int h = std::min(graph_h, (int)(ms * graph_h / 33.3f));
+    bars[i] = {gx + engine::PROFILE_HISTORY - f.count + i, gy + graph_h - h, 1, h};
+  }
+  SDL_SetRenderDrawColor(ren, 80, 200, 80, 255);
+  if (f.count > 0)
+    engine::prof_render_fill_rects(ren, bars, f.count);
+  SDL_SetRenderDrawColor(ren, 200, 200, 80, 255);
+  engine::prof_render_draw_line(ren, gx, gy + graph_h / 2, gx + engine::PROFILE_HISTORY - 1, gy + graph_h / 2);
+
+  if (!font)
+    return;
+  const SDL_Color fg = {255, 255, 255, 255};
+  char buf[96];
+  int ty = gy + graph_h + pad;
+  snprintf(buf, sizeof(buf), "frame %.2f ms (avg %.2f)",
+           f.count ? f.frame_ms[(f.head + f.count - 1) % engine::PROFILE_HISTORY] : 0.0f,
+           f.count ? total / f.count : 0.0f);
+  draw_text(ren, font, buf, gx, ty, fg);
+  ty += line_h;
+  snprintf(buf, sizeof(buf), "draw calls %u  textures %u", f.draw_calls, f.textures_created);
+  draw_text(ren, font, buf, gx, ty, fg);
+  for (const engine::ProfileStage &s : f.stages) {
+    ty += line_h;
+    snprintf(buf, sizeof(buf), "%-20s %6.2f ms", s.name, s.ms);
+    draw_text(ren, font, buf, gx, ty, fg);
+  }
 }
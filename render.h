@@ -8,22 +8,54 @@ extern SDL_Texture* g_wall_tex;
 extern SDL_Texture* g_floor_tex;
 extern SDL_Texture* g_item_tex;
 
+// How the 3D view is drawn; chosen at startup
+enum class RenderPath {
+    Renderer,    // one SDL_RenderCopy/SDL_RenderDrawLine per column
+    Framebuffer  // raycast into a CPU pixel buffer, one texture upload per frame
+};
+extern RenderPath g_render_path;
+
+struct PixelImage;
+
+// Loads an image from the asset pack, falling back to the file at path, and
+// optionally keeps its CPU pixels in img. Null (with an error) on failure.
+SDL_Texture* load_image_texture(SDL_Renderer* ren, const char* path, PixelImage* img);
+// True when the image is in the asset pack or the file exists
+bool image_available(const char* path);
+
 // Load and free textures
 bool load_dungeon_textures(SDL_Renderer* ren);
 void free_dungeon_textures();
 
-// Raycasting-based dungeon renderer
-void render_dungeon(SDL_Renderer* ren, const Player& player, const Monster* monster, int win_w, int top_h, int bottom_h);
+// Raycasting-based dungeon renderer. Monsters (dead ones skipped) and queued
+// items are drawn by the sprite stage, occluded per column by the walls.
+void render_dungeon(SDL_Renderer* ren, const Player& player, const Monster* monsters, int monster_count,
+                    int win_w, int top_h, int bottom_h);
 
-// Renders the minimap (stub)
-void render_minimap(SDL_Renderer* ren, const Player& player, int win_w, int top_h, int bottom_h);
+// Queues an item (at a tile) for the next render_dungeon call
+void queue_item_sprite(int x, int y);
+
+// Renders the minimap: a cached tile layer plus an overlay of the player and
+// the given monsters (dead ones are skipped)
+void render_minimap(SDL_Renderer* ren, const Player& player, const Monster* monsters, int monster_count,
+                    int win_w, int top_h, int bottom_h);
+void free_minimap();
 
 // Draws party/status area under the window
 // Stores the rectangles for attack buttons for each party member
 extern SDL_Rect g_attack_btn_rects[3];
 
-// Render party status and update attack button rects
+// Render party status and update attack button rects. The panel is retained:
+// it is redrawn only when a member's stats, the font or the window size change.
 void render_party_status(SDL_Renderer* ren, const Party& party, TTF_Font* font, int win_w, int top_h, int bottom_h);
 
+// Forces a panel redraw (e.g. after SDL_RENDER_TARGETS_RESET)
+void invalidate_party_panel();
+void free_party_panel();
+
+// Draws the profiler overlay (frame time graph, per-stage ms, draw calls and
+// texture creations) in the top-right corner
+void render_profiler_overlay(SDL_Renderer* ren, TTF_Font* font, int win_w, int win_h);
+
 // Returns the rectangle for the attack button for the given member index (0-2)
 static inline SDL_Rect get_attack_btn_rect(int idx) { return g_attack_btn_rects[idx]; }
@@ -0,0 +1,132 @@
+#include "sprites.h"
+#include "engine/workers.h"
+#include "engine/profile_sdl.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+struct Sprite {
+    float x, y; // world position
+    const SpriteImage* image;
+};
+
+// A sprite that survived culling, in screen space
+struct Projected {
+    float depth;    // camera-space distance, compared against the depth buffer
+    int x0, size;   // left screen column and square size in pixels
+    const SpriteImage* image;
+};
+
+std::vector<Sprite> g_sprites;      // this frame's queue
+std::vector<Projected> g_visible;   // reused sort buffer
+
+// Sprites closer than this are inside the player's tile
+const float NEAR_PLANE = 0.2f;
+
+void draw_renderer(SDL_Renderer* ren, const Projected& p, const float* zbuf, int view_w, int view_h) {
+    SDL_Texture* tex = p.image->tex;
+    int tex_w, tex_h;
+    if (!tex || SDL_QueryTexture(tex, nullptr, nullptr, &tex_w, &tex_h) != 0)
+        return;
+    SDL_SetTextureColorMod(tex, p.image->tint.r, p.image->tint.g, p.image->tint.b);
+    int cx0 = std::max(0, p.x0), cx1 = std::min(view_w, p.x0 + p.size);
+    int y0 = (view_h - p.size) / 2;
+    // One copy per run of columns in front of the walls
+    int run = -1;
+    for (int x = cx0; x <= cx1; ++x) {
+        bool visible = x < cx1 && p.depth < zbuf[x];
+        if (visible && run < 0)
+            run = x;
+        if (!visible && run >= 0) {
+            int sx0 = (run - p.x0) * tex_w / p.size;
+            int sx1 = (x - p.x0) * tex_w / p.size;
+            SDL_Rect src = {sx0, 0, std::max(1, sx1 - sx0), tex_h};
+            SDL_Rect dst = {run, y0, x - run, p.size};
+            engine::prof_render_copy(ren, tex, &src, &dst);
+            run = -1;
+        }
+    }
+    SDL_SetTextureColorMod(tex, 255, 255, 255);
+}
+
+// Columns [a, b) of one sprite, alpha-tested into the framebuffer
+void draw_columns(Framebuffer& fb, const Projected& p, const float* zbuf, int a, int b) {
+    const PixelImage& img = *p.image->px;
+    const SDL_Color tint = p.image->tint;
+    const bool tinted = tint.r != 255 || tint.g != 255 || tint.b != 255;
+    int cx0 = std::max(a, p.x0), cx1 = std::min(b, p.x0 + p.size);
+    int y0 = (fb.h - p.size) / 2;
+    int ry0 = std::max(0, y0), ry1 = std::min(fb.h, y0 + p.size);
+    int64_t step = ((int64_t)img.h << 16) / p.size;
+    for (int x = cx0; x < cx1; ++x) {
+        if (p.depth >= zbuf[x])
+            continue;
+        int tex_x = (int)((int64_t)(x - p.x0) * img.w / p.size);
+        const Uint32* col = img.px + tex_x;
+        Uint32* dst = fb.pixels.data() + (size_t)ry0 * fb.w + x;
+        int64_t tex_pos = (int64_t)(ry0 - y0) * step;
+        for (int y = ry0; y < ry1; ++y, dst += fb.w, tex_pos += step) {
+            int tex_y = std::min((int)(tex_pos >> 16), img.h - 1);
+            Uint32 c = col[(size_t)tex_y * img.pitch];
+            if ((c >> 24) < 128)
+                continue;
+            if (tinted)
+                c = 0xFF000000 | ((((c >> 16) & 0xFF) * tint.r / 255) << 16) |
+                    ((((c >> 8) & 0xFF) * tint.g / 255) << 8) | ((c & 0xFF) * tint.b / 255);
+            *dst = c;
+        }
+    }
+}
+} // namespace
+
+void sprites_clear() { g_sprites.clear(); }
+
+void sprites_add(float x, float y, const SpriteImage* image) {
+    if (image)
+        g_sprites.push_back({x, y, image});
+}
+
+void sprites_draw(SDL_Renderer* ren, Framebuffer* fb, const Camera& cam, const float* zbuf,
+                  int view_w, int view_h) {
+    g_visible.clear();
+    if (g_sprites.empty() || view_w <= 0 || view_h <= 0)
+        return;
+    // Nothing beyond the farthest wall can be seen
+    float max_depth = *std::max_element(zbuf, zbuf + view_w);
+    float inv_det = 1.0f / (cam.plane_x * cam.dir_y - cam.dir_x * cam.plane_y);
+    for (const Sprite& s : g_sprites) {
+        float rel_x = s.x - cam.pos_x;
+        float rel_y = s.y - cam.pos_y;
+        // Transform to camera space
+        float trans_y = inv_det * (-cam.plane_y * rel_x + cam.plane_x * rel_y);
+        if (trans_y < NEAR_PLANE || trans_y >= max_depth)
+            continue; // behind the camera or past every wall
+        float trans_x = inv_det * (cam.dir_y * rel_x - cam.dir_x * rel_y);
+        int size = abs(int(view_h / trans_y));
+        int screen_x = int((view_w / 2) * (1 + trans_x / trans_y));
+        int x0 = screen_x - size / 2;
+        if (size <= 0 || x0 + size <= 0 || x0 >= view_w)
+            continue; // outside the horizontal field of view
+        if (fb ? !s.image->px || s.image->px->w <= 0 : !s.image->tex)
+            continue;
+        g_visible.push_back({trans_y, x0, size, s.image});
+    }
+    // Farthest to nearest so closer sprites overdraw farther ones
+    std::sort(g_visible.begin(), g_visible.end(),
+              [](const Projected& a, const Projected& b) { return a.depth > b.depth; });
+
+    if (fb) {
+        // Column strips are independent: each strip walks the sorted list
+        engine::parallel_for(0, view_w, 1, [&](int a, int b) {
+            for (const Projected& p : g_visible)
+                if (p.x0 < b && p.x0 + p.size > a)
+                    draw_columns(*fb, p, zbuf, a, b);
+        });
+        return;
+    }
+    SDL_Rect view = {0, 0, view_w, view_h};
+    SDL_RenderSetClipRect(ren, &view);
+    for (const Projected& p : g_visible)
+        draw_renderer(ren, p, zbuf, view_w, view_h);
+    SDL_RenderSetClipRect(ren, nullptr);
+}
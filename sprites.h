@@ -0,0 +1,23 @@
+#pragma once
+#include "raycast.h"
+#include "framebuffer.h"
+
+// Sprite image: the texture is used by the renderer path, the pixels by
+// the framebuffer path. tint multiplies the image color.
+struct SpriteImage {
+    SDL_Texture* tex = nullptr;
+    const PixelImage* px = nullptr;
+    SDL_Color tint = {255, 255, 255, 255};
+};
+
+// Sprite stage of the 3D view. Sprites are queued every frame, then
+// culled in camera space, sorted far to near in a reused buffer and
+// drawn column by column against the per-column wall depth buffer.
+void sprites_clear();
+void sprites_add(float x, float y, const SpriteImage* image);
+
+// Draws the queued sprites into fb when given, otherwise through the
+// renderer (clipped to the view_w x view_h view at the window origin).
+// zbuf holds the perpendicular wall distance of every column.
+void sprites_draw(SDL_Renderer* ren, Framebuffer* fb, const Camera& cam, const float* zbuf,
+                  int view_w, int view_h);
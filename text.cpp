@@ -0,0 +1,234 @@
+#include "text.h"
+#include "engine/profile_sdl.h"
+#include "engine/log.h"
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Glyph {
+    SDL_Rect rect = {0, 0, 0, 0}; // location in the atlas
+    int advance = 0;
+    bool loaded = false;
+};
+
+struct GlyphAtlas {
+    SDL_Renderer* ren = nullptr;
+    TTF_Font* font = nullptr;
+    int height = 0;                  // font height the glyphs were rasterized at
+    int tex_w = 0, tex_h = 0;
+    std::vector<Uint32> pixels;      // CPU copy, kept for re-uploads on growth
+    SDL_Texture* tex = nullptr;
+    int shelf_x = 0, shelf_y = 0, shelf_h = 0;
+    Glyph ascii[128];
+    std::unordered_map<Uint32, Glyph> other;
+};
+
+const int ATLAS_W = 512;
+const int ATLAS_MAX_H = 4096;
+
+std::vector<std::unique_ptr<GlyphAtlas>> g_atlases;
+// Reused between draws: glyph quads for SDL_RenderGeometry (SDL 2.0.18+),
+// or source and destination rects to copy one by one on older SDL
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+std::vector<SDL_Vertex> g_vertices;
+std::vector<int> g_indices;
+#else
+std::vector<std::pair<SDL_Rect, SDL_Rect>> g_copies;
+#endif
+
+bool atlas_upload(GlyphAtlas& a) {
+    if (a.tex)
+        SDL_DestroyTexture(a.tex);
+    a.tex = engine::prof_create_texture(a.ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, a.tex_w, a.tex_h);
+    if (!a.tex) {
+        LOG_ERROR(Render, "SDL_CreateTexture failed for glyph atlas: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(a.tex, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(a.tex, nullptr, a.pixels.data(), a.tex_w * (int)sizeof(Uint32));
+    return true;
+}
+
+void load_glyph(GlyphAtlas& a, Uint32 cp, Glyph& g);
+
+GlyphAtlas* get_atlas(SDL_Renderer* ren, TTF_Font* font) {
+    int height = TTF_FontHeight(font);
+    for (auto& a : g_atlases)
+        if (a->ren == ren && a->font == font && a->height == height)
+            return a.get();
+    auto a = std::make_unique<GlyphAtlas>();
+    a->ren = ren;
+    a->font = font;
+    a->height = height;
+    a->tex_w = ATLAS_W;
+    a->tex_h = 256;
+    a->pixels.assign((size_t)a->tex_w * a->tex_h, 0);
+    if (!atlas_upload(*a))
+        return nullptr;
+    // Printable ASCII up front, so the HUD never rasterizes mid-game
+    for (Uint32 cp = 32; cp < 127; ++cp)
+        load_glyph(*a, cp, a->ascii[cp]);
+    g_atlases.push_back(std::move(a));
+    return g_atlases.back().get();
+}
+
+// Rasterizes one glyph into the atlas (white, tinted at draw time)
+void load_glyph(GlyphAtlas& a, Uint32 cp, Glyph& g) {
+    g.loaded = true;
+    int minx, maxx, miny, maxy;
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+    if (TTF_GlyphMetrics32(a.font, cp, &minx, &maxx, &miny, &maxy, &g.advance) != 0)
+        return;
+    SDL_Surface* surf = TTF_RenderGlyph32_Blended(a.font, cp, SDL_Color{255, 255, 255, 255});
+#else
+    if (cp > 0xFFFF || TTF_GlyphMetrics(a.font, (Uint16)cp, &minx, &maxx, &miny, &maxy, &g.advance) != 0)
+        return;
+    SDL_Surface* surf = TTF_RenderGlyph_Blended(a.font, (Uint16)cp, SDL_Color{255, 255, 255, 255});
+#endif
+    if (!surf)
+        return;
+    SDL_Surface* argb = surf;
+    if (surf->format->format != SDL_PIXELFORMAT_ARGB8888)
+        argb = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (argb && argb->w <= a.tex_w) {
+        // Shelf packing; grow the atlas downwards when it runs out of room
+        if (a.shelf_x + argb->w > a.tex_w) {
+            a.shelf_x = 0;
+            a.shelf_y += a.shelf_h + 1;
+            a.shelf_h = 0;
+        }
+        bool fits = a.shelf_y + argb->h <= a.tex_h;
+        if (!fits && a.tex_h * 2 <= ATLAS_MAX_H) {
+            a.tex_h *= 2;
+            a.pixels.resize((size_t)a.tex_w * a.tex_h, 0);
+            fits = atlas_upload(a) && a.shelf_y + argb->h <= a.tex_h;
+        }
+        if (fits) {
+            g.rect = {a.shelf_x, a.shelf_y, argb->w, argb->h};
+            for (int y = 0; y < argb->h; ++y)
+                memcpy(&a.pixels[(size_t)(g.rect.y + y) * a.tex_w + g.rect.x],
+                       (const Uint8*)argb->pixels + y * argb->pitch, argb->w * sizeof(Uint32));
+            SDL_UpdateTexture(a.tex, &g.rect, &a.pixels[(size_t)g.rect.y * a.tex_w + g.rect.x],
+                              a.tex_w * (int)sizeof(Uint32));
+            a.shelf_x += argb->w + 1;
+            if (argb->h > a.shelf_h)
+                a.shelf_h = argb->h;
+        }
+    }
+    if (argb != surf)
+        SDL_FreeSurface(argb);
+    SDL_FreeSurface(surf);
+}
+
+const Glyph& get_glyph(GlyphAtlas& a, Uint32 cp) {
+    Glyph* g;
+    if (cp < 128) {
+        g = &a.ascii[cp];
+    } else {
+        auto it = a.other.find(cp);
+        g = it != a.other.end() ? &it->second : &a.other[cp];
+    }
+    if (!g->loaded)
+        load_glyph(a, cp, *g);
+    return *g;
+}
+
+// Decodes one UTF-8 code point and advances s; invalid bytes become '?'
+Uint32 next_code_point(const unsigned char*& s) {
+    Uint32 c = *s++;
+    if (c < 0x80)
+        return c;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+    if (extra < 0)
+        return '?';
+    c &= 0x3F >> extra;
+    for (int i = 0; i < extra; ++i) {
+        if ((*s & 0xC0) != 0x80)
+            return '?';
+        c = (c << 6) | (*s++ & 0x3F);
+    }
+    return c;
+}
+
+} // namespace
+
+void draw_text(SDL_Renderer* ren, TTF_Font* font, const char* utf8, int x, int y, SDL_Color color) {
+    if (!font || !utf8)
+        return;
+    GlyphAtlas* a = get_atlas(ren, font);
+    if (!a)
+        return;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    g_vertices.clear();
+    g_indices.clear();
+#else
+    g_copies.clear();
+#endif
+    int pen_x = x;
+    for (const unsigned char* s = (const unsigned char*)utf8; *s;) {
+        const Glyph& g = get_glyph(*a, next_code_point(s));
+        if (g.rect.w > 0) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+            float x0 = (float)pen_x, y0 = (float)y;
+            float x1 = x0 + g.rect.w, y1 = y0 + g.rect.h;
+            float u0 = (float)g.rect.x / a->tex_w, v0 = (float)g.rect.y / a->tex_h;
+            float u1 = (float)(g.rect.x + g.rect.w) / a->tex_w, v1 = (float)(g.rect.y + g.rect.h) / a->tex_h;
+            int base = (int)g_vertices.size();
+            g_vertices.push_back({{x0, y0}, color, {u0, v0}});
+            g_vertices.push_back({{x1, y0}, color, {u1, v0}});
+            g_vertices.push_back({{x1, y1}, color, {u1, v1}});
+            g_vertices.push_back({{x0, y1}, color, {u0, v1}});
+            const int quad[6] = {0, 1, 2, 0, 2, 3};
+            for (int i : quad)
+                g_indices.push_back(base + i);
+#else
+            g_copies.push_back({g.rect, SDL_Rect{pen_x, y, g.rect.w, g.rect.h}});
+#endif
+        }
+        pen_x += g.advance;
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (g_vertices.empty())
+        return;
+    engine::prof_render_geometry(ren, a->tex, g_vertices.data(), (int)g_vertices.size(), g_indices.data(),
+                                 (int)g_indices.size());
+#else
+    // No geometry API: one copy per glyph from the same atlas texture
+    if (g_copies.empty())
+        return;
+    SDL_SetTextureColorMod(a->tex, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(a->tex, color.a);
+    for (const auto& c : g_copies)
+        engine::prof_render_copy(ren, a->tex, &c.first, &c.second);
+#endif
+}
+
+void measure_text(SDL_Renderer* ren, TTF_Font* font, const char* utf8, int* w, int* h) {
+    int width = 0;
+    GlyphAtlas* a = font && utf8 ? get_atlas(ren, font) : nullptr;
+    if (a)
+        for (const unsigned char* s = (const unsigned char*)utf8; *s;)
+            width += get_glyph(*a, next_code_point(s)).advance;
+    if (w)
+        *w = width;
+    if (h)
+        *h = a ? a->height : 0;
+}
+
+void draw_text_centered(SDL_Renderer* ren, TTF_Font* font, const char* utf8, const SDL_Rect& rect,
+                        SDL_Color color) {
+    int tw, th;
+    measure_text(ren, font, utf8, &tw, &th);
+    draw_text(ren, font, utf8, rect.x + (rect.w - tw) / 2, rect.y + (rect.h - th) / 2, color);
+}
+
+void free_text_cache() {
+    for (auto& a : g_atlases)
+        if (a->tex)
+            SDL_DestroyTexture(a->tex);
+    g_atlases.clear();
+}
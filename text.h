@@ -0,0 +1,20 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+// Text drawing through per-font glyph atlases. Each glyph is rasterized once
+// into an atlas texture (cached per font and size); strings are then drawn
+// as one batch of textured quads, with no surface or texture churn.
+
+// Draws UTF-8 text with its top-left corner at (x, y)
+void draw_text(SDL_Renderer* ren, TTF_Font* font, const char* utf8, int x, int y, SDL_Color color);
+
+// Size of the text as draw_text lays it out
+void measure_text(SDL_Renderer* ren, TTF_Font* font, const char* utf8, int* w, int* h);
+
+// Draws text centered inside rect
+void draw_text_centered(SDL_Renderer* ren, TTF_Font* font, const char* utf8, const SDL_Rect& rect,
+                        SDL_Color color);
+
+// Destroys every atlas (call before destroying the renderer or closing fonts)
+void free_text_cache();
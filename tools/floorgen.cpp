@@ -0,0 +1,229 @@
+// moravor_floorgen: runs a floor style's generator over a range of seeds on
+// every core and measures each floor, for tuning the generators and finding
+// good (or degenerate) seeds. Prints throughput and a summary as JSON.
+//
+//   moravor_floorgen [--style=maze|caves|halls] [--seeds=1000000]
+//                    [--first-seed=1] [--size=16x14] [--threads=0]
+//                    [--out=floors.fgc]
+//
+// Per floor: path length from entrance to exit (steps, -1 if unreachable),
+// dead ends (floor tiles with one open neighbour), open-tile ratio, room
+// count, and how many separate areas of floor the generator had to join and
+// how many walls that took.
+//
+// --out writes the results in columns (little-endian): a 32-byte header
+// ("MVFG", uint32 version 3, w, h, first seed, seed count, rows per group,
+// uint32 style: 0 maze, 1 caves, 2 halls), then row groups of up to that many floors in seed order,
+// each holding one array per column:
+//   uint32 seed, int32 path_len, uint32 dead_ends, float open_ratio,
+//   uint8 rooms, uint32 areas, uint32 carved
+#include "random_floor.h"
+#include "engine/workers.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t GROUP_ROWS = 65536;
+
+struct Columns {
+    std::vector<uint32_t> seed;
+    std::vector<int32_t> path_len;
+    std::vector<uint32_t> dead_ends;
+    std::vector<float> open_ratio;
+    std::vector<uint8_t> rooms;
+    std::vector<uint32_t> areas;
+    std::vector<uint32_t> carved;
+
+    void resize(size_t n) {
+        seed.resize(n);
+        path_len.resize(n);
+        dead_ends.resize(n);
+        open_ratio.resize(n);
+        rooms.resize(n);
+        areas.resize(n);
+        carved.resize(n);
+    }
+};
+
+// Scratch reused across floors by one strip
+struct Scratch {
+    std::vector<int32_t> dist;
+    std::vector<int32_t> queue;
+};
+
+inline bool open_tile(char c) { return c == '.' || c == 'E' || c == 'X'; }
+
+// One raster pass for the tile counts, then a breadth-first search from the
+// entrance for the path length
+void measure(const std::vector<std::string>& map, std::pair<int,int> entrance, std::pair<int,int> exit,
+             Scratch& s, int32_t& path_len, uint32_t& dead_ends, float& open_ratio) {
+    const int w = (int)map[0].size(), h = (int)map.size();
+    uint32_t open = 0, ends = 0;
+    for (int y = 0; y < h; ++y) {
+        const char* up = y > 0 ? map[y - 1].data() : nullptr;
+        const char* row = map[y].data();
+        const char* down = y + 1 < h ? map[y + 1].data() : nullptr;
+        for (int x = 0; x < w; ++x) {
+            if (row[x] != '.')
+                continue;
+            ++open;
+            const int exits = (x > 0 && open_tile(row[x - 1])) + (x + 1 < w && open_tile(row[x + 1])) +
+                              (up && open_tile(up[x])) + (down && open_tile(down[x]));
+            ends += exits == 1;
+        }
+    }
+    dead_ends = ends;
+    open_ratio = (float)open / ((float)w * h);
+
+    static const int dx[4] = {0, 1, 0, -1};
+    static const int dy[4] = {-1, 0, 1, 0};
+    s.dist.assign((size_t)w * h, -1);
+    s.queue.clear();
+    const int start = entrance.second * w + entrance.first, goal = exit.second * w + exit.first;
+    s.dist[start] = 0;
+    s.queue.push_back(start);
+    path_len = -1;
+    for (size_t head = 0; head < s.queue.size(); ++head) {
+        const int i = s.queue[head];
+        if (i == goal) {
+            path_len = s.dist[i];
+            break;
+        }
+        const int x = i % w, y = i / w;
+        for (int d = 0; d < 4; ++d) {
+            const int nx = x + dx[d], ny = y + dy[d];
+            if (nx < 0 || nx >= w || ny < 0 || ny >= h)
+                continue;
+            const int n = ny * w + nx;
+            if (s.dist[n] < 0 && open_tile(map[ny][nx])) {
+                s.dist[n] = s.dist[i] + 1;
+                s.queue.push_back(n);
+            }
+        }
+    }
+}
+
+template <typename T>
+bool write_column(FILE* f, const std::vector<T>& v, size_t n) {
+    return fwrite(v.data(), sizeof(T), n, f) == n;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t seeds = 1000000;
+    uint32_t first_seed = 1;
+    int w = 16, h = 14, threads = 0;
+    const char* out_path = nullptr;
+    FloorStyle style = FloorStyle::Maze;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--style=", 8) == 0) {
+            std::vector<FloorStyle> styles;
+            if (!parse_floor_styles(argv[i] + 8, styles) || styles.size() != 1) {
+                std::cerr << "Bad floor style (maze, caves or halls): " << argv[i] + 8 << std::endl;
+                return 1;
+            }
+            style = styles[0];
+        } else if (strncmp(argv[i], "--seeds=", 8) == 0) {
+            seeds = strtoull(argv[i] + 8, nullptr, 10);
+        } else if (strncmp(argv[i], "--first-seed=", 13) == 0) {
+            first_seed = (uint32_t)std::max(1ul, strtoul(argv[i] + 13, nullptr, 10));
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (sscanf(argv[i] + 7, "%dx%d", &w, &h) != 2 || w < 16 || h < 14) {
+                std::cerr << "Bad size (at least 16x14): " << argv[i] + 7 << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out_path = argv[i] + 6;
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    // Seed 0 means "random" to the generator, so the range must not wrap to it
+    seeds = std::min<uint64_t>(seeds, UINT32_MAX - (uint64_t)first_seed + 1);
+
+    FILE* out = nullptr;
+    if (out_path) {
+        out = fopen(out_path, "wb");
+        if (!out) {
+            std::cerr << "Cannot write " << out_path << std::endl;
+            return 1;
+        }
+        uint32_t header[8] = {0, 3, (uint32_t)w, (uint32_t)h, first_seed, (uint32_t)seeds, GROUP_ROWS, (uint32_t)style};
+        memcpy(header, "MVFG", 4);
+        fwrite(header, sizeof(header), 1, out);
+    }
+
+    engine::workers_init(threads);
+    const FloorGenerator generate = floor_generator(style);
+    Columns cols;
+    uint64_t joined = 0, carved = 0, unreachable = 0, path_sum = 0, reached = 0;
+    int32_t longest = -1;
+    uint32_t longest_seed = 0;
+    bool ok = true;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t base = 0; base < seeds; base += GROUP_ROWS) {
+        const int n = (int)std::min<uint64_t>(GROUP_ROWS, seeds - base);
+        cols.resize(n);
+        engine::parallel_for(0, n, 1, [&](int begin, int end) {
+            Scratch scratch;
+            for (int r = begin; r < end; ++r) {
+                const uint32_t seed = first_seed + (uint32_t)(base + r);
+                std::pair<int,int> entrance, exit;
+                FloorGenStats stats;
+                std::vector<std::string> map = generate(w, h, entrance, exit, seed, &stats);
+                cols.seed[r] = seed;
+                cols.rooms[r] = (uint8_t)stats.rooms;
+                cols.areas[r] = stats.areas;
+                cols.carved[r] = stats.carved;
+                measure(map, entrance, exit, scratch, cols.path_len[r], cols.dead_ends[r], cols.open_ratio[r]);
+            }
+        });
+        for (int r = 0; r < n; ++r) {
+            joined += cols.areas[r] > 1;
+            carved += cols.carved[r];
+            if (cols.path_len[r] < 0) {
+                ++unreachable;
+                continue;
+            }
+            ++reached;
+            path_sum += cols.path_len[r];
+            if (cols.path_len[r] > longest) {
+                longest = cols.path_len[r];
+                longest_seed = cols.seed[r];
+            }
+        }
+        if (out)
+            ok = ok && write_column(out, cols.seed, n) && write_column(out, cols.path_len, n) &&
+                 write_column(out, cols.dead_ends, n) && write_column(out, cols.open_ratio, n) &&
+                 write_column(out, cols.rooms, n) && write_column(out, cols.areas, n) &&
+                 write_column(out, cols.carved, n);
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const int thread_count = engine::workers_thread_count();
+    engine::workers_shutdown();
+    if (out && (fclose(out) != 0 || !ok)) {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        return 1;
+    }
+
+    printf("{\n  \"style\": \"%s\",\n  \"w\": %d,\n  \"h\": %d,\n  \"first_seed\": %u,\n  \"seeds\": %llu,\n  \"threads\": %d,\n"
+           "  \"seconds\": %.3f,\n  \"seeds_per_s\": %.1f,\n  \"joined_floors\": %llu,\n  \"carved_tiles\": %llu,\n"
+           "  \"unreachable_floors\": %llu,\n  \"mean_path_len\": %.2f,\n  \"longest_path_len\": %d,\n"
+           "  \"longest_path_seed\": %u\n}\n",
+           floor_style_name(style), w, h, first_seed, (unsigned long long)seeds, thread_count, secs, secs > 0 ? seeds / secs : 0.0,
+           (unsigned long long)joined, (unsigned long long)carved, (unsigned long long)unreachable, reached ? (double)path_sum / reached : 0.0,
+           longest, longest_seed);
+    return 0;
+}
@@ -0,0 +1,165 @@
+// moravor_gen_bench: times each floor style's generator over a range of
+// floor sizes and prints the time, throughput and memory per style and size
+// as JSON. Each style and size runs in a child process of its own, so its
+// peak RSS covers that floor alone: peak_rss_kb is the child's, and
+// gen_rss_kb how far generating took it above its RSS at the start. (On
+// Windows they run in process and report no memory.)
+//
+//   moravor_gen_bench [--styles=maze,caves,halls] [--sizes=64,1024,10000]
+//                     [--seed=1] [--repeat=1] [--out=file.json]
+#include "random_floor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+long peak_rss_kb() {
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss;
+#endif
+    return 0;
+}
+
+// Order-sensitive checksum of a floor, to compare generator changes
+uint64_t fnv1a(const std::vector<std::string>& map) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const std::string& row : map)
+        for (char c : row)
+            h = (h ^ (unsigned char)c) * 0x100000001b3ull;
+    return h;
+}
+
+struct Run {
+    double best_ms = 0;
+    uint64_t checksum = 0;
+    long base_rss_kb = 0, peak_rss_kb = 0;
+};
+
+// Best time over repeat calls; the checksum is the last floor's
+Run run(FloorGenerator generate, int size, unsigned seed, int repeat) {
+    Run r;
+    r.base_rss_kb = peak_rss_kb();
+    for (int i = 0; i < repeat; ++i) {
+        std::pair<int,int> entrance, exit;
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::string> map = generate(size, size, entrance, exit, seed, nullptr);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        r.best_ms = i == 0 ? ms : std::min(r.best_ms, ms);
+        r.checksum = fnv1a(map);
+    }
+    r.peak_rss_kb = peak_rss_kb();
+    return r;
+}
+
+// run() in a child process, results back through a pipe; false if it failed
+bool run_isolated(FloorGenerator generate, int size, unsigned seed, int repeat, Run& r) {
+#ifndef _WIN32
+    int fds[2];
+    if (pipe(fds) != 0)
+        return false;
+    fflush(nullptr);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        const Run child = run(generate, size, seed, repeat);
+        const bool sent = write(fds[1], &child, sizeof(child)) == (ssize_t)sizeof(child);
+        _exit(sent ? 0 : 1);
+    }
+    close(fds[1]);
+    const bool got = read(fds[0], &r, sizeof(r)) == (ssize_t)sizeof(r);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+    r = run(generate, size, seed, repeat);
+    r.base_rss_kb = r.peak_rss_kb = 0;
+    return true;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<FloorStyle> styles = {FloorStyle::Maze, FloorStyle::Caves, FloorStyle::Halls};
+    std::vector<int> sizes = {64, 1024, 10000};
+    unsigned seed = 1;
+    int repeat = 1;
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--styles=", 9) == 0) {
+            if (!parse_floor_styles(argv[i] + 9, styles)) {
+                std::cerr << "Bad floor styles (maze, caves, halls): " << argv[i] + 9 << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--sizes=", 8) == 0) {
+            sizes.clear();
+            for (const char* p = argv[i] + 8; *p;) {
+                char* end;
+                long v = strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                if (v >= 16)
+                    sizes.push_back((int)v);
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = (unsigned)std::max(1, atoi(argv[i] + 7));
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = std::max(1, atoi(argv[i] + 9));
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out_path = argv[i] + 6;
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        out = stdout;
+    }
+    fprintf(out, "{\n  \"seed\": %u,\n  \"results\": [\n", seed);
+    for (size_t st = 0; st < styles.size(); ++st) {
+        const char* name = floor_style_name(styles[st]);
+        const FloorGenerator generate = floor_generator(styles[st]);
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            const int size = sizes[s];
+            std::cerr << "Running " << name << " " << size << "x" << size << std::endl;
+            Run r;
+            if (!run_isolated(generate, size, seed, repeat, r)) {
+                std::cerr << "Generating " << name << " " << size << "x" << size << " failed" << std::endl;
+                return 1;
+            }
+            const bool last = st + 1 == styles.size() && s + 1 == sizes.size();
+            fprintf(out,
+                    "    {\"style\": \"%s\", \"w\": %d, \"h\": %d, \"ms\": %.3f, \"mtiles_per_s\": %.1f, "
+                    "\"peak_rss_kb\": %ld, \"gen_rss_kb\": %ld, \"checksum\": \"%016llx\"}%s\n",
+                    name, size, size, r.best_ms, (double)size * size / (r.best_ms * 1e3), r.peak_rss_kb,
+                    r.peak_rss_kb - r.base_rss_kb, (unsigned long long)r.checksum, last ? "" : ",");
+        }
+    }
+    fprintf(out, "  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
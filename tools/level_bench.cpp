@@ -0,0 +1,508 @@
+// moravor_level_bench: times tile lookups the way the hot callers make them
+// (scattered lookups, DDA ray marches, a walkable flood fill, whole-view
+// column casts) over seeded floors. It compares the old row-of-strings
+// lookup with the flat grid: checked get_tile, get_tile_unchecked and the
+// solidity bitmask. It prints
+// nanoseconds per operation as JSON: per tile looked at, or per column for
+// cast_columns.
+//
+//   moravor_level_bench [--rays=N] [--repeat=N] [--out=file.json]
+//   moravor_level_bench --verify
+//   moravor_level_bench --verify-rebuild
+//   moravor_level_bench --verify-map
+//
+// --verify times nothing: it casts views of seeded floors at several widths
+// through both cast_columns paths and fails (exit code 1) on the first hit
+// that differs in any bit. --verify-rebuild edits tiles and moves monsters
+// on generated floors, lets the level drop them and fails unless rebuilding
+// brings every change back. --verify-map saves a floor as .mvm, loads it
+// back, and fails unless copies with a floor tile in the border, a wrong
+// solid bit or the entrance off the map are each turned away. ctest runs all
+// three.
+#include "level.h"
+#include "engine/mapfile.h"
+#include "random_floor.h"
+#include "raycast.h"
+#include "game/entities.h"
+#include "game/pregen.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct FloorSpec {
+    unsigned seed;
+    int w, h;
+};
+const FloorSpec FLOORS[] = {{1, 33, 33}, {2, 129, 129}, {3, 257, 257}};
+
+// Solid tiles among the given coordinates (x, y pairs); returns the count
+// looked at
+template <typename Solid>
+uint64_t lookup(const std::vector<int>& coords, Solid solid, uint64_t& checksum) {
+    uint64_t hits = 0;
+    for (size_t i = 0; i < coords.size(); i += 2)
+        hits += solid(coords[i], coords[i + 1]);
+    checksum += hits;
+    return coords.size() / 2;
+}
+
+// The storage level.h had before the flat grid, kept here as the baseline
+std::vector<std::string> g_rows;
+char legacy_get_tile(int x, int y) {
+    if (x < 0 || x >= (int)g_rows[0].size() || y < 0 || y >= (int)g_rows.size())
+        return TILE_WALL;
+    return g_rows[y][x];
+}
+
+struct Ray {
+    float x, y, dx, dy;
+};
+
+// Same stepping as cast_column, stopping at the first solid tile; returns
+// the number of tiles looked at
+template <typename Solid>
+uint64_t march(const std::vector<Ray>& rays, Solid solid, uint64_t& checksum) {
+    uint64_t lookups = 0;
+    for (const Ray& r : rays) {
+        int map_x = (int)r.x, map_y = (int)r.y;
+        float delta_x = r.dx == 0 ? 1e30f : fabsf(1.0f / r.dx);
+        float delta_y = r.dy == 0 ? 1e30f : fabsf(1.0f / r.dy);
+        int step_x = r.dx < 0 ? -1 : 1, step_y = r.dy < 0 ? -1 : 1;
+        float side_x = (r.dx < 0 ? r.x - map_x : map_x + 1.0f - r.x) * delta_x;
+        float side_y = (r.dy < 0 ? r.y - map_y : map_y + 1.0f - r.y) * delta_y;
+        for (;;) {
+            if (side_x < side_y) {
+                side_x += delta_x;
+                map_x += step_x;
+            } else {
+                side_y += delta_y;
+                map_y += step_y;
+            }
+            ++lookups;
+            if (solid(map_x, map_y))
+                break;
+        }
+        checksum += (uint64_t)map_x * 31 + map_y;
+    }
+    return lookups;
+}
+
+// Breadth-first fill of the walkable tiles from (sx, sy); returns the
+// number of tiles looked at
+template <typename Tile>
+uint64_t flood(int w, int h, int sx, int sy, Tile tile, uint64_t& checksum) {
+    static const int DX[4] = {0, 1, 0, -1};
+    static const int DY[4] = {-1, 0, 1, 0};
+    std::vector<uint8_t> seen((size_t)w * h, 0);
+    std::vector<int> open;
+    open.reserve((size_t)w * h);
+    open.push_back(sy * w + sx);
+    seen[sy * w + sx] = 1;
+    uint64_t lookups = 0;
+    for (size_t i = 0; i < open.size(); ++i) {
+        int x = open[i] % w, y = open[i] / w;
+        for (int d = 0; d < 4; ++d) {
+            int nx = x + DX[d], ny = y + DY[d];
+            ++lookups;
+            if (!is_walkable(tile(nx, ny)) || seen[ny * w + nx])
+                continue;
+            seen[ny * w + nx] = 1;
+            open.push_back(ny * w + nx);
+        }
+    }
+    checksum += open.size();
+    return lookups;
+}
+
+struct Result {
+    std::string floor;
+    const char* test;
+    const char* access;
+    uint64_t ops;
+    double ns_per_op;
+};
+
+template <typename Fn>
+void time_best(std::vector<Result>& out, const std::string& floor, const char* test, const char* access,
+               int repeat, Fn fn) {
+    double best = 1e300;
+    uint64_t ops = 0;
+    for (int i = 0; i < repeat; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        ops = fn();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        best = std::min(best, ns);
+    }
+    out.push_back({floor, test, access, ops, ops ? best / ops : 0.0});
+}
+
+bool same_hit(const RayHit& a, const RayHit& b) {
+    return memcmp(&a.perp_wall_dist, &b.perp_wall_dist, sizeof(float)) == 0 && a.side == b.side &&
+           a.map_x == b.map_x && a.map_y == b.map_y && a.tile == b.tile && a.tex_x == b.tex_x;
+}
+
+// Packet and scalar casts of every view (floor tile and facing, up to a few
+// hundred per floor) at several widths, whole and part views; 0 when all
+// hits match
+int verify_casts() {
+    static const FloorSpec VERIFY_FLOORS[] = {{1, 33, 33}, {2, 129, 129}, {7, 48, 20}, {11, 20, 64}, {12, 257, 257}};
+    static const int WIDTHS[] = {1, 3, 4, 7, 8, 9, 15, 16, 17, 320, 641, 1920};
+    static const int TEX_WIDTHS[] = {64, 37};
+    uint64_t columns = 0;
+    for (const FloorSpec& spec : VERIFY_FLOORS) {
+        std::pair<int, int> entrance, exit;
+        set_level_data(generate_random_floor(spec.w, spec.h, entrance, exit, spec.seed));
+        std::vector<Player> poses;
+        for (int y = 0; y < MAP_H && poses.size() < 1024; ++y)
+            for (int x = 0; x < MAP_W; ++x)
+                if (get_tile(x, y) == TILE_FLOOR)
+                    for (int dir = 0; dir < 4; ++dir) {
+                        Player p;
+                        p.x = x;
+                        p.y = y;
+                        p.dir = dir;
+                        poses.push_back(p);
+                    }
+        for (int view_w : WIDTHS) {
+            std::vector<RayHit> packet(view_w), scalar(view_w);
+            for (int tex_w : TEX_WIDTHS) {
+                for (const Player& p : poses) {
+                    const Camera cam = make_camera(p);
+                    // The whole view, then a part not starting on a packet
+                    for (int part = 0; part < 2; ++part) {
+                        const int x0 = part ? std::min(3, view_w - 1) : 0;
+                        const int x1 = part ? std::max(x0 + 1, view_w - 2) : view_w;
+                        cast_columns(cam, x0, x1, view_w, tex_w, packet.data());
+                        cast_columns_scalar(cam, x0, x1, view_w, tex_w, scalar.data());
+                        for (int x = x0; x < x1; ++x) {
+                            if (same_hit(packet[x], scalar[x]))
+                                continue;
+                            const RayHit& a = packet[x];
+                            const RayHit& b = scalar[x];
+                            fprintf(stderr,
+                                    "cast_columns mismatch: floor %dx%d seed %u, player (%d,%d) dir %d, view %d "
+                                    "tex %d, column %d: packet dist %a side %d tile (%d,%d) tex_x %d, scalar dist "
+                                    "%a side %d tile (%d,%d) tex_x %d\n",
+                                    spec.w, spec.h, spec.seed, p.x, p.y, p.dir, view_w, tex_w, x,
+                                    a.perp_wall_dist, a.side, a.map_x, a.map_y, a.tex_x, b.perp_wall_dist,
+                                    b.side, b.map_x, b.map_y, b.tex_x);
+                            return 1;
+                        }
+                        columns += x1 - x0;
+                    }
+                }
+            }
+        }
+    }
+    printf("cast_columns: %llu columns identical (packet width %d)\n", (unsigned long long)columns,
+           raycast_packet_width());
+    return 0;
+}
+
+bool same_monsters(const std::vector<Monster>& a, const std::vector<Monster>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].dir != b[i].dir || a[i].state != b[i].state ||
+            a[i].agility != b[i].agility)
+            return false;
+    return true;
+}
+
+// Generated floors kept the way the game keeps them (game::rebuild_floor,
+// one built at a time). Each gets set_tile() edits, enough repeats to
+// compact its log, a moved monster and an added one; then every floor is
+// visited again in order, rebuilt from its seed, and must match. 0 when all
+// do.
+int verify_rebuild() {
+    const int FLOOR_COUNT = 6, W = 48, H = 40;
+    struct Visited {
+        int idx;
+        std::vector<char> tiles, solid;
+        std::vector<Monster> spawn, monsters;
+        game::EntityDelta delta;
+    };
+    std::vector<Visited> visited;
+    set_floor_rebuild(game::rebuild_floor, 1);
+    std::mt19937 rng(1);
+    for (int i = 1; i <= FLOOR_COUNT; ++i) {
+        game::FloorBuild build;
+        game::generate_floor(i, W, H, game::floor_seed(1, i), build);
+        Visited v;
+        v.spawn = build.monsters;
+        v.idx = add_floor(std::move(build.storage), build.seed);
+        set_current_floor(v.idx);
+        // Inside tiles flipped between wall and floor, many times over
+        std::vector<std::pair<int, int>> picks;
+        for (int k = 0; k < 40; ++k)
+            picks.emplace_back(1 + rng() % (W - 2), 1 + rng() % (H - 2));
+        for (int round = 0; round < 60; ++round)
+            for (const auto& t : picks)
+                set_tile(t.first, t.second, (round + t.first) % 2 ? TILE_WALL : TILE_FLOOR);
+        for (int y = 0; y < MAP_H; ++y)
+            for (int x = 0; x < MAP_W; ++x) {
+                v.tiles.push_back(get_tile(x, y));
+                v.solid.push_back(is_solid_unchecked(x, y));
+            }
+
+        game::FloorEntities ents;
+        ents.monsters = v.spawn;
+        game::entities_unpack(ents, MAP_W, MAP_H);
+        for (int k = 0; k < 2; ++k) {
+            int x, y;
+            do {
+                x = rng() % MAP_W;
+                y = rng() % MAP_H;
+            } while (get_tile(x, y) != TILE_FLOOR);
+            if (k == 0) {
+                game::entities_move(ents, 0, x, y);
+            } else {
+                Monster m = v.spawn[0];
+                m.x = x;
+                m.y = y;
+                m.agility = 7;
+                game::entities_add(ents, m);
+            }
+        }
+        v.monsters = ents.monsters;
+        game::entities_drop(ents, v.spawn, v.delta);
+        visited.push_back(std::move(v));
+    }
+
+    // The last floor went when the first came back, and so on
+    for (auto v = visited.begin(); v != visited.end(); ++v) {
+        const bool dropped = !is_floor_built(v->idx);
+        set_current_floor(v->idx);
+        std::vector<Monster> spawn;
+        if (!dropped || get_current_floor() != v->idx || !game::take_rebuilt_spawn(v->idx, spawn)) {
+            fprintf(stderr, "floor %d was not dropped and rebuilt\n", v->idx);
+            return 1;
+        }
+        size_t i = 0;
+        for (int y = 0; y < MAP_H; ++y)
+            for (int x = 0; x < MAP_W; ++x, ++i)
+                if (get_tile(x, y) != v->tiles[i] || is_solid_unchecked(x, y) != (bool)v->solid[i]) {
+                    fprintf(stderr, "floor %d tile (%d,%d) is '%c' (solid %d) after the rebuild, was '%c' (solid %d)\n",
+                            v->idx, x, y, get_tile(x, y), (int)is_solid_unchecked(x, y), v->tiles[i], v->solid[i]);
+                    return 1;
+                }
+        game::FloorEntities ents;
+        game::entities_restore(ents, spawn, v->delta, MAP_W, MAP_H);
+        if (!same_monsters(spawn, v->spawn) || !same_monsters(ents.monsters, v->monsters)) {
+            fprintf(stderr, "floor %d monsters differ after the rebuild\n", v->idx);
+            return 1;
+        }
+    }
+    printf("floor rebuild: %d floors identical after rebuilding\n", FLOOR_COUNT);
+    return 0;
+}
+
+// A generated floor written out, read back, and written again broken three
+// ways (offsets from the header, so the layout isn't assumed); each broken
+// file must fail to load and leave the level as it was. 0 when all do.
+int verify_map_file() {
+    const char* path = "moravor_verify_map.mvm";
+    std::pair<int, int> entrance, exit;
+    const std::vector<std::string> map = generate_random_floor(40, 30, entrance, exit, 5);
+    set_current_floor(add_floor(map, entrance, exit));
+    if (!save_level_file(path) || !load_level_file(path) || MAP_W != 40 || MAP_H != 30 || get_entrance_pos() != entrance) {
+        fprintf(stderr, "a saved floor did not load back\n");
+        return 1;
+    }
+    std::vector<unsigned char> good;
+    if (FILE* f = fopen(path, "rb")) {
+        unsigned char buf[4096];
+        for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;)
+            good.insert(good.end(), buf, buf + n);
+        fclose(f);
+    }
+    engine::MapFileHeader hdr;
+    memcpy(&hdr, good.data(), sizeof(hdr));
+    const size_t stride = hdr.w + 2, solid_stride = (stride + 63) / 64;
+    // Tile (x, y) of the padded grid and its solid bit
+    auto tile = [&](std::vector<unsigned char>& d, int x, int y) -> unsigned char& {
+        return d[hdr.tiles_offset + (y + 1) * stride + x + 1];
+    };
+    auto flip_solid = [&](std::vector<unsigned char>& d, int x, int y) {
+        const size_t bit = x + 1;
+        d[hdr.solid_offset + ((y + 1) * solid_stride + (bit >> 6)) * 8 + (bit & 63) / 8] ^= 1 << (bit % 8);
+    };
+    struct Broken {
+        const char* what;
+        std::vector<unsigned char> data;
+    };
+    std::vector<Broken> broken(3, {nullptr, good});
+    // Floor in the border, solid bit cleared to match, so only the border is off
+    broken[0].what = "a floor tile in the border";
+    tile(broken[0].data, -1, 5) = TILE_FLOOR;
+    flip_solid(broken[0].data, -1, 5);
+    broken[1].what = "a solid bit that doesn't match its tile";
+    flip_solid(broken[1].data, 3, 3);
+    broken[2].what = "the entrance off the map";
+    hdr.entrance_x = hdr.w;
+    memcpy(broken[2].data.data(), &hdr, sizeof(hdr));
+    int failed = 0;
+    for (const Broken& b : broken) {
+        FILE* f = fopen(path, "wb");
+        const bool written = f && fwrite(b.data.data(), 1, b.data.size(), f) == b.data.size();
+        if (f)
+            fclose(f);
+        const unsigned version = get_level_version();
+        if (!written || load_level_file(path) || get_level_version() != version) {
+            fprintf(stderr, "a map with %s was not turned away\n", b.what);
+            ++failed;
+        }
+    }
+    remove(path);
+    if (!failed)
+        printf("map files: %zu broken maps turned away\n", broken.size());
+    return failed ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int ray_count = 200000, repeat = 5;
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--rays=", 7) == 0) {
+            ray_count = std::max(1, atoi(argv[i] + 7));
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = std::max(1, atoi(argv[i] + 9));
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out_path = argv[i] + 6;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            return verify_casts();
+        } else if (strcmp(argv[i], "--verify-rebuild") == 0) {
+            return verify_rebuild();
+        } else if (strcmp(argv[i], "--verify-map") == 0) {
+            return verify_map_file();
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    uint64_t checksum = 0;
+    for (const FloorSpec& spec : FLOORS) {
+        std::pair<int, int> entrance, exit;
+        g_rows = generate_random_floor(spec.w, spec.h, entrance, exit, spec.seed);
+        set_level_data(g_rows);
+        const std::string floor = std::to_string(MAP_W) + "x" + std::to_string(MAP_H);
+        std::cerr << "Running " << floor << std::endl;
+
+        // Rays from random floor tiles in random directions
+        std::mt19937 rng(spec.seed);
+        std::vector<Ray> rays;
+        rays.reserve(ray_count);
+        while ((int)rays.size() < ray_count) {
+            int x = rng() % MAP_W, y = rng() % MAP_H;
+            if (get_tile(x, y) != TILE_FLOOR)
+                continue;
+            float a = (rng() % 36000) * (float)M_PI / 18000.0f;
+            rays.push_back({x + 0.5f, y + 0.5f, cosf(a), sinf(a)});
+        }
+        // Scattered lookups, border included
+        std::vector<int> coords((size_t)ray_count * 2);
+        for (size_t i = 0; i < coords.size(); i += 2) {
+            coords[i] = (int)(rng() % (MAP_W + 2)) - 1;
+            coords[i + 1] = (int)(rng() % (MAP_H + 2)) - 1;
+        }
+        time_best(results, floor, "random_lookup", "legacy_rows", repeat, [&] {
+            return lookup(coords, [](int x, int y) { return is_solid(legacy_get_tile(x, y)); }, checksum);
+        });
+        time_best(results, floor, "random_lookup", "get_tile", repeat, [&] {
+            return lookup(coords, [](int x, int y) { return is_solid(get_tile(x, y)); }, checksum);
+        });
+        time_best(results, floor, "random_lookup", "get_tile_unchecked", repeat, [&] {
+            return lookup(coords, [](int x, int y) { return is_solid(get_tile_unchecked(x, y)); }, checksum);
+        });
+        time_best(results, floor, "random_lookup", "solid_mask", repeat, [&] {
+            return lookup(coords, [](int x, int y) { return is_solid_unchecked(x, y); }, checksum);
+        });
+
+        time_best(results, floor, "ray_march", "legacy_rows", repeat, [&] {
+            return march(rays, [](int x, int y) { return is_solid(legacy_get_tile(x, y)); }, checksum);
+        });
+        time_best(results, floor, "ray_march", "get_tile", repeat, [&] {
+            return march(rays, [](int x, int y) { return is_solid(get_tile(x, y)); }, checksum);
+        });
+        time_best(results, floor, "ray_march", "get_tile_unchecked", repeat, [&] {
+            return march(rays, [](int x, int y) { return is_solid(get_tile_unchecked(x, y)); }, checksum);
+        });
+        time_best(results, floor, "ray_march", "solid_mask", repeat, [&] {
+            return march(rays, [](int x, int y) { return is_solid_unchecked(x, y); }, checksum);
+        });
+
+        // Flood fill from the first floor tile
+        int sx = -1, sy = -1;
+        for (int y = 0; y < MAP_H && sx < 0; ++y)
+            for (int x = 0; x < MAP_W; ++x)
+                if (get_tile(x, y) == TILE_FLOOR) {
+                    sx = x;
+                    sy = y;
+                    break;
+                }
+        if (sx >= 0) {
+            time_best(results, floor, "flood_fill", "legacy_rows", repeat,
+                      [&] { return flood(MAP_W, MAP_H, sx, sy, legacy_get_tile, checksum); });
+            time_best(results, floor, "flood_fill", "get_tile", repeat,
+                      [&] { return flood(MAP_W, MAP_H, sx, sy, get_tile, checksum); });
+            time_best(results, floor, "flood_fill", "get_tile_unchecked", repeat,
+                      [&] { return flood(MAP_W, MAP_H, sx, sy, get_tile_unchecked, checksum); });
+        }
+
+        // Whole 1920-column views from the first few hundred ray origins
+        const int view_w = 1920;
+        std::vector<RayHit> hits(view_w);
+        auto cast_views = [&](bool packets) {
+            uint64_t columns = 0;
+            for (size_t i = 0; i < rays.size() && i < 256; ++i) {
+                Player p;
+                p.x = (int)rays[i].x;
+                p.y = (int)rays[i].y;
+                p.dir = (int)i % 4;
+                Camera cam = make_camera(p);
+                if (packets)
+                    cast_columns(cam, 0, view_w, view_w, 64, hits.data());
+                else
+                    cast_columns_scalar(cam, 0, view_w, view_w, 64, hits.data());
+                checksum += hits[view_w / 2].map_x;
+                columns += view_w;
+            }
+            return columns;
+        };
+        time_best(results, floor, "cast_columns", "scalar", repeat, [&] { return cast_views(false); });
+        time_best(results, floor, "cast_columns", "packet", repeat, [&] { return cast_views(true); });
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        out = stdout;
+    }
+    fprintf(out, "{\n  \"rays\": %d,\n  \"packet_width\": %d,\n  \"checksum\": %llu,\n  \"results\": [\n", ray_count,
+            raycast_packet_width(), (unsigned long long)checksum);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        fprintf(out,
+                "%s    {\"floor\": \"%s\", \"test\": \"%s\", \"access\": \"%s\", \"ops\": %llu, "
+                "\"ns_per_op\": %.3f}",
+                i ? ",\n" : "", r.floor.c_str(), r.test, r.access, (unsigned long long)r.ops,
+                r.ns_per_op);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,186 @@
+// moravor_pack: decodes PNGs once at build time into an asset pack the game
+// maps at startup (see engine/assetpack.h).
+//
+//   moravor_pack out.pak [--atlas] images... [--page] images...
+//
+// Images after --atlas (the default) share shelf-packed atlas pages; images
+// after --page get a page of their own. Entries are named by file name.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "engine/assetpack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace engine;
+
+struct Image {
+    std::string name;
+    int w = 0, h = 0;
+    std::vector<uint32_t> px; // ARGB8888
+    bool own_page = false;
+    uint32_t page = 0, x = 0, y = 0;
+};
+
+struct Page {
+    uint32_t w = 0, h = 0;
+    std::vector<uint32_t> px;
+};
+
+static bool load_image(const char* path, Image& img) {
+    int n = 0;
+    unsigned char* rgba = stbi_load(path, &img.w, &img.h, &n, 4);
+    if (!rgba) {
+        std::cerr << "stbi_load failed: " << path << " - " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    img.px.resize((size_t)img.w * img.h);
+    for (size_t i = 0; i < img.px.size(); ++i) {
+        const unsigned char* p = rgba + i * 4;
+        img.px[i] = (uint32_t)p[3] << 24 | (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+    }
+    stbi_image_free(rgba);
+    const char* slash = strrchr(path, '/');
+    img.name = slash ? slash + 1 : path;
+    if (img.name.size() >= sizeof(PackEntry::name)) {
+        std::cerr << "Image name too long: " << img.name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static uint32_t pow2_at_least(uint32_t v) {
+    uint32_t p = 1;
+    while (p < v)
+        p <<= 1;
+    return p;
+}
+
+// Shelf-packs the atlas images, tallest first, into pages whose width is a
+// power of two (so the floor kernel can index them with a shift)
+static void pack_atlas(std::vector<Image*>& atlas, std::vector<Page>& pages) {
+    if (atlas.empty())
+        return;
+    const uint32_t max_h = 2048;
+    uint32_t widest = 0;
+    for (Image* img : atlas)
+        widest = std::max(widest, (uint32_t)img->w);
+    const uint32_t page_w = std::max(256u, pow2_at_least(widest));
+    std::stable_sort(atlas.begin(), atlas.end(), [](const Image* a, const Image* b) { return a->h > b->h; });
+    uint32_t page = (uint32_t)pages.size(), x = 0, y = 0, shelf_h = 0;
+    pages.push_back({page_w, 0, {}});
+    for (Image* img : atlas) {
+        if (x + img->w > page_w) {
+            x = 0;
+            y += shelf_h;
+            shelf_h = 0;
+        }
+        if (y + img->h > max_h && y > 0) {
+            page = (uint32_t)pages.size();
+            pages.push_back({page_w, 0, {}});
+            x = y = shelf_h = 0;
+        }
+        img->page = page;
+        img->x = x;
+        img->y = y;
+        x += img->w;
+        shelf_h = std::max(shelf_h, (uint32_t)img->h);
+        pages[page].h = std::max(pages[page].h, y + img->h);
+    }
+}
+
+static void blit(Page& page, const Image& img) {
+    for (int y = 0; y < img.h; ++y)
+        memcpy(&page.px[(size_t)(img.y + y) * page.w + img.x], &img.px[(size_t)y * img.w],
+               img.w * sizeof(uint32_t));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: moravor_pack out.pak [--atlas] images... [--page] images..." << std::endl;
+        return 1;
+    }
+    std::vector<Image> images;
+    bool own_page = false;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--atlas") == 0) {
+            own_page = false;
+        } else if (strcmp(argv[i], "--page") == 0) {
+            own_page = true;
+        } else {
+            Image img;
+            if (!load_image(argv[i], img))
+                return 1;
+            img.own_page = own_page;
+            images.push_back(std::move(img));
+        }
+    }
+
+    std::vector<Page> pages;
+    std::vector<Image*> atlas;
+    for (Image& img : images)
+        if (!img.own_page)
+            atlas.push_back(&img);
+    pack_atlas(atlas, pages);
+    for (Image& img : images) {
+        if (!img.own_page)
+            continue;
+        img.page = (uint32_t)pages.size();
+        pages.push_back({(uint32_t)img.w, (uint32_t)img.h, {}});
+    }
+    for (Page& page : pages)
+        page.px.assign((size_t)page.w * page.h, 0);
+    for (const Image& img : images)
+        blit(pages[img.page], img);
+
+    PackHeader hdr = {};
+    memcpy(hdr.magic, PACK_MAGIC, 4);
+    hdr.version = PACK_VERSION;
+    hdr.format = PACK_FORMAT_ARGB8888;
+    hdr.page_count = (uint32_t)pages.size();
+    hdr.entry_count = (uint32_t)images.size();
+    std::vector<PackPage> page_table(pages.size());
+    uint64_t offset = sizeof(PackHeader) + page_table.size() * sizeof(PackPage) + images.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        offset = (offset + 63) & ~(uint64_t)63;
+        page_table[i] = {pages[i].w, pages[i].h, offset};
+        offset += (uint64_t)pages[i].w * pages[i].h * 4;
+    }
+    std::vector<PackEntry> entries(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        PackEntry& e = entries[i];
+        memset(&e, 0, sizeof(e));
+        strncpy(e.name, images[i].name.c_str(), sizeof(e.name) - 1);
+        e.page = images[i].page;
+        e.x = images[i].x;
+        e.y = images[i].y;
+        e.w = images[i].w;
+        e.h = images[i].h;
+    }
+
+    FILE* f = fopen(argv[1], "wb");
+    if (!f) {
+        std::cerr << "Cannot write " << argv[1] << std::endl;
+        return 1;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    ok = ok && fwrite(page_table.data(), sizeof(PackPage), page_table.size(), f) == page_table.size();
+    ok = ok && fwrite(entries.data(), sizeof(PackEntry), entries.size(), f) == entries.size();
+    static const char zeros[64] = {};
+    for (size_t i = 0; ok && i < pages.size(); ++i) {
+        long pad = (long)page_table[i].offset - ftell(f);
+        ok = pad >= 0 && fwrite(zeros, 1, pad, f) == (size_t)pad;
+        ok = ok && fwrite(pages[i].px.data(), sizeof(uint32_t), pages[i].px.size(), f) == pages[i].px.size();
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed writing " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << images.size() << " images into " << pages.size() << " pages (" << offset
+              << " bytes): " << argv[1] << std::endl;
+    return 0;
+}
@@ -0,0 +1,340 @@
+// moravor_render_bench: replays scripted camera paths over seeded floors
+// through the 3D view, minimap and party panel, headless (dummy video
+// driver, software renderer), and prints per-stage frame time percentiles
+// as JSON.
+//
+//   moravor_render_bench [--render=sdl|framebuffer|both] [--threads=N]
+//                        [--resolutions=800x600,1280x720] [--font=path]
+//                        [--out=file.json] [--trace=trace.json]
+#include "level.h"
+#include "player.h"
+#include "random_floor.h"
+#include "raycast.h"
+#include "render.h"
+#include "text.h"
+#include "engine/workers.h"
+#include "engine/profiler.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Resolution {
+    int w, h;
+};
+
+// The floors every run replays: seed and size
+struct FloorSpec {
+    unsigned seed;
+    int w, h;
+};
+const FloorSpec FLOORS[] = {{1, 16, 14}, {2, 33, 33}, {3, 65, 65}, {4, 129, 129}};
+
+// Poses are at most this many steps along the path, plus the idle frames
+const int MAX_PATH_STEPS = 160;
+const int IDLE_FRAMES = 40;
+
+enum Stage { STAGE_DUNGEON, STAGE_MINIMAP, STAGE_PARTY, STAGE_COUNT };
+const char* const STAGE_NAMES[STAGE_COUNT] = {"dungeon", "minimap", "party"};
+
+struct Pose {
+    int x, y, dir;
+};
+
+struct Script {
+    std::vector<std::string> map;
+    std::vector<Pose> poses;
+    Monster monster;
+    std::pair<int, int> item;
+};
+
+const int DX[4] = {0, 1, 0, -1};
+const int DY[4] = {-1, 0, 1, 0};
+
+// Shortest walkable path between two doorways (the doorway tiles themselves
+// are not walkable)
+std::vector<std::pair<int, int>> find_path(const std::vector<std::string>& map, std::pair<int, int> from,
+                                           std::pair<int, int> to) {
+    const int h = (int)map.size(), w = (int)map[0].size();
+    std::vector<int> prev((size_t)w * h, -1);
+    std::queue<int> open;
+    open.push(from.second * w + from.first);
+    prev[from.second * w + from.first] = from.second * w + from.first;
+    while (!open.empty()) {
+        int cur = open.front();
+        open.pop();
+        if (cur == to.second * w + to.first)
+            break;
+        for (int d = 0; d < 4; ++d) {
+            int nx = cur % w + DX[d], ny = cur / w + DY[d];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h || prev[ny * w + nx] >= 0)
+                continue;
+            if (!is_walkable(map[ny][nx]) && ny * w + nx != to.second * w + to.first)
+                continue;
+            prev[ny * w + nx] = cur;
+            open.push(ny * w + nx);
+        }
+    }
+    std::vector<std::pair<int, int>> path;
+    int cur = to.second * w + to.first;
+    if (prev[cur] < 0)
+        return path;
+    while (true) {
+        path.emplace_back(cur % w, cur / w);
+        if (prev[cur] == cur)
+            break;
+        cur = prev[cur];
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// Walks from the entrance towards the exit facing the way it moves, looking
+// around every few tiles, then stands still (the cached case)
+Script make_script(const FloorSpec& spec) {
+    Script s;
+    std::pair<int, int> entrance, exit;
+    s.map = generate_random_floor(spec.w, spec.h, entrance, exit, spec.seed);
+    auto path = find_path(s.map, entrance, exit);
+    if (path.size() > 2)
+        path = std::vector<std::pair<int, int>>(path.begin() + 1, path.end() - 1);
+    else
+        path.assign(1, entrance);
+    if ((int)path.size() > MAX_PATH_STEPS)
+        path.resize(MAX_PATH_STEPS);
+    int dir = 0;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i + 1 < path.size())
+            for (int d = 0; d < 4; ++d)
+                if (path[i].first + DX[d] == path[i + 1].first && path[i].second + DY[d] == path[i + 1].second)
+                    dir = d;
+        s.poses.push_back({path[i].first, path[i].second, dir});
+        if (i % 6 == 3)
+            for (int t = 1; t <= 4; ++t)
+                s.poses.push_back({path[i].first, path[i].second, (dir + t) % 4});
+    }
+    for (int i = 0; i < IDLE_FRAMES; ++i)
+        s.poses.push_back(s.poses.back());
+    auto at = [&](size_t num, size_t den) { return path[std::min(path.size() - 1, path.size() * num / den)]; };
+    s.monster = {at(1, 2).first, at(1, 2).second, 0, MonsterState::Agro};
+    s.item = at(1, 3);
+    return s;
+}
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t rank = (size_t)std::ceil(p * v.size());
+    return v[std::min(v.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+struct Result {
+    const char* path;
+    Resolution res;
+    std::vector<double> ms[STAGE_COUNT];
+};
+
+// Runs every script at one resolution on a fresh software renderer
+bool run(const std::vector<Script>& scripts, Resolution res, TTF_Font* font, Result& result) {
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, res.w, res.h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!target) {
+        std::cerr << "SDL_CreateRGBSurfaceWithFormat failed: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_Renderer* ren = SDL_CreateSoftwareRenderer(target);
+    if (!ren) {
+        std::cerr << "SDL_CreateSoftwareRenderer failed: " << SDL_GetError() << std::endl;
+        SDL_FreeSurface(target);
+        return false;
+    }
+    bool ok = load_dungeon_textures(ren);
+    if (!ok)
+        std::cerr << "Failed to load dungeon textures!" << std::endl;
+    const int top_h = res.h * 0.6, bottom_h = res.h - top_h;
+    const double tick_ms = 1000.0 / SDL_GetPerformanceFrequency();
+    Party party;
+    party.count = 3;
+    for (int i = 0; i < 3; ++i) {
+        player_init(party.members[i]);
+        party.members[i].name = "Member " + std::to_string(i + 1);
+    }
+    for (size_t f = 0; ok && f < scripts.size(); ++f) {
+        const Script& s = scripts[f];
+        set_level_data(s.map);
+        for (size_t i = 0; i < s.poses.size(); ++i) {
+            Player& p = party.members[0];
+            p.x = s.poses[i].x;
+            p.y = s.poses[i].y;
+            p.dir = s.poses[i].dir;
+            // Someone takes a hit now and then, so the panel redraws
+            if (i % 20 == 19)
+                party.members[1 + i / 20 % 2].hp = std::max(1, party.members[1 + i / 20 % 2].hp - 1);
+            SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+            SDL_RenderClear(ren);
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            queue_item_sprite(s.item.first, s.item.second);
+            render_dungeon(ren, p, &s.monster, 1, res.w, top_h, bottom_h);
+            Uint64 t1 = SDL_GetPerformanceCounter();
+            render_minimap(ren, p, &s.monster, 1, res.w, top_h, bottom_h);
+            Uint64 t2 = SDL_GetPerformanceCounter();
+            render_party_status(ren, party, font, res.w, top_h, bottom_h);
+            Uint64 t3 = SDL_GetPerformanceCounter();
+            SDL_RenderPresent(ren);
+            engine::profile_frame_end();
+            result.ms[STAGE_DUNGEON].push_back((t1 - t0) * tick_ms);
+            result.ms[STAGE_MINIMAP].push_back((t2 - t1) * tick_ms);
+            result.ms[STAGE_PARTY].push_back((t3 - t2) * tick_ms);
+        }
+    }
+    free_dungeon_textures();
+    free_party_panel();
+    free_minimap();
+    free_text_cache();
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(target);
+    return ok;
+}
+
+bool parse_resolutions(const char* arg, std::vector<Resolution>& out) {
+    out.clear();
+    while (*arg) {
+        Resolution r;
+        int n = 0;
+        if (sscanf(arg, "%dx%d%n", &r.w, &r.h, &n) != 2 || r.w <= 0 || r.h <= 0)
+            return false;
+        out.push_back(r);
+        arg += n;
+        if (*arg == ',')
+            ++arg;
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<Resolution> resolutions = {{800, 600}, {1280, 720}, {1920, 1080}, {2560, 1440}};
+    std::vector<RenderPath> paths = {RenderPath::Renderer, RenderPath::Framebuffer};
+    int threads = 0;
+    const char* font_path = "/usr/share/fonts/TTF/DejaVuSerifCondensed.ttf";
+    const char* out_path = nullptr;
+    const char* trace_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = atoi(argv[i] + 10);
+        } else if (strcmp(argv[i], "--render=sdl") == 0) {
+            paths = {RenderPath::Renderer};
+        } else if (strcmp(argv[i], "--render=framebuffer") == 0 || strcmp(argv[i], "--render=soft") == 0) {
+            paths = {RenderPath::Framebuffer};
+        } else if (strcmp(argv[i], "--render=both") == 0) {
+            paths = {RenderPath::Renderer, RenderPath::Framebuffer};
+        } else if (strncmp(argv[i], "--resolutions=", 14) == 0) {
+            if (!parse_resolutions(argv[i] + 14, resolutions)) {
+                std::cerr << "Bad resolution list: " << argv[i] + 14 << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--font=", 7) == 0) {
+            font_path = argv[i] + 7;
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out_path = argv[i] + 6;
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_path = argv[i] + 8; // profiler zones, with MORAVOR_PROFILE
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // No display needed: the dummy driver unless one was chosen explicitly
+    if (!getenv("SDL_VIDEODRIVER"))
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        std::cerr << "SDL_Init Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    if (TTF_Init() != 0 || !(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        std::cerr << "TTF_Init/IMG_Init failed" << std::endl;
+        SDL_Quit();
+        return 1;
+    }
+    TTF_Font* font = TTF_OpenFont(font_path, 32);
+    if (!font)
+        std::cerr << "No font (" << font_path << "), the party panel is drawn without text" << std::endl;
+    engine::workers_init(threads);
+    engine::profiler_set_enabled(trace_path != nullptr);
+
+    std::vector<Script> scripts;
+    for (const FloorSpec& spec : FLOORS)
+        scripts.push_back(make_script(spec));
+
+    std::vector<Result> results;
+    bool ok = true;
+    for (RenderPath path : paths) {
+        g_render_path = path;
+        for (Resolution res : resolutions) {
+            Result r;
+            r.path = path == RenderPath::Framebuffer ? "framebuffer" : "sdl";
+            r.res = res;
+            std::cerr << "Running " << r.path << " " << res.w << "x" << res.h << std::endl;
+            if (!run(scripts, res, font, r)) {
+                ok = false;
+                break;
+            }
+            results.push_back(std::move(r));
+        }
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        out = stdout;
+    }
+    fprintf(out, "{\n  \"video_driver\": \"%s\",\n  \"threads\": %d,\n  \"packet_width\": %d,\n",
+            SDL_GetCurrentVideoDriver() ? SDL_GetCurrentVideoDriver() : "none", engine::workers_thread_count(),
+            raycast_packet_width());
+    fprintf(out, "  \"floors\": [");
+    for (size_t i = 0; i < sizeof(FLOORS) / sizeof(FLOORS[0]); ++i)
+        fprintf(out, "%s{\"seed\": %u, \"w\": %d, \"h\": %d, \"frames\": %zu}", i ? ", " : "", FLOORS[i].seed,
+                FLOORS[i].w, FLOORS[i].h, scripts[i].poses.size());
+    fprintf(out, "],\n  \"results\": [\n");
+    bool first = true;
+    for (const Result& r : results) {
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const std::vector<double>& v = r.ms[s];
+            double mean = 0.0;
+            for (double ms : v)
+                mean += ms;
+            mean = v.empty() ? 0.0 : mean / v.size();
+            fprintf(out,
+                    "%s    {\"path\": \"%s\", \"resolution\": \"%dx%d\", \"stage\": \"%s\", \"frames\": %zu, "
+                    "\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f}",
+                    first ? "" : ",\n", r.path, r.res.w, r.res.h, STAGE_NAMES[s], v.size(), mean,
+                    percentile(v, 0.50), percentile(v, 0.95), percentile(v, 0.99));
+            first = false;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    if (trace_path)
+        engine::profiler_write_chrome_trace(trace_path);
+
+    engine::workers_shutdown();
+    if (font)
+        TTF_CloseFont(font);
+    IMG_Quit();
+    TTF_Quit();
+    SDL_Quit();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// moravor_tmx2mvm: converts a Tiled map (.tmx) into the game's binary floor
+// format (.mvm, engine/mapfile.h). Run by the build for every
+// assets/maps/*.tmx so the game never parses XML.
+//
+//   moravor_tmx2mvm in.tmx out.mvm
+//
+// Tile layers are stacked in file order (non-empty cells of later layers
+// win); empty cells are wall. A tileset tile becomes the level character in
+// its "tile" string property (e.g. "#", "."); tiles without one fall back to
+// their index in the tileset: 0 wall, 1 floor, 2 entrance, 3 exit. Objects
+// named (or typed) "entrance" / "exit" mark those tiles too. Layer data may
+// be CSV, XML or uncompressed Base64; infinite maps are not supported.
+#include "level.h"
+#include <pugixml.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Tiled keeps flip/rotation flags in the top bits of a gid
+const uint32_t GID_MASK = 0x0FFFFFFF;
+
+const char FALLBACK_TILES[] = {TILE_WALL, TILE_FLOOR, TILE_ENTRANCE, TILE_EXIT};
+
+struct Tileset {
+    uint32_t firstgid;
+    std::map<uint32_t, char> chars; // local id -> level character
+};
+
+std::string directory_of(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+bool read_tileset(const pugi::xml_node& node, uint32_t firstgid, Tileset& out) {
+    out.firstgid = firstgid;
+    for (pugi::xml_node tile : node.children("tile")) {
+        for (pugi::xml_node prop : tile.child("properties").children("property")) {
+            if (strcmp(prop.attribute("name").as_string(), "tile") != 0)
+                continue;
+            const char* value = prop.attribute("value").as_string();
+            if (strlen(value) != 1) {
+                std::cerr << "Tile " << tile.attribute("id").as_uint() << ": \"tile\" must be one character"
+                          << std::endl;
+                return false;
+            }
+            out.chars[tile.attribute("id").as_uint()] = value[0];
+        }
+    }
+    return true;
+}
+
+bool decode_base64(const char* text, std::vector<unsigned char>& out) {
+    auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    };
+    uint32_t acc = 0;
+    int bits = 0;
+    for (; *text; ++text) {
+        if (*text == '=' || isspace((unsigned char)*text))
+            continue;
+        int v = value(*text);
+        if (v < 0)
+            return false;
+        acc = acc << 6 | v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back((unsigned char)(acc >> bits));
+        }
+    }
+    return true;
+}
+
+// Reads one layer's gids, row-major
+bool read_layer(const pugi::xml_node& layer, int w, int h, std::vector<uint32_t>& gids) {
+    pugi::xml_node data = layer.child("data");
+    if (data.child("chunk")) {
+        std::cerr << "Infinite maps are not supported" << std::endl;
+        return false;
+    }
+    const std::string encoding = data.attribute("encoding").as_string();
+    gids.clear();
+    if (encoding == "csv") {
+        const char* p = data.child_value();
+        while (*p) {
+            char* end;
+            unsigned long v = strtoul(p, &end, 10);
+            if (end == p) {
+                ++p;
+                continue;
+            }
+            gids.push_back((uint32_t)v);
+            p = end;
+        }
+    } else if (encoding == "base64") {
+        if (data.attribute("compression")) {
+            std::cerr << "Compressed layer data is not supported; save with CSV or uncompressed Base64" << std::endl;
+            return false;
+        }
+        std::vector<unsigned char> bytes;
+        if (!decode_base64(data.child_value(), bytes)) {
+            std::cerr << "Bad Base64 layer data" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i + 4 <= bytes.size(); i += 4)
+            gids.push_back(bytes[i] | bytes[i + 1] << 8 | bytes[i + 2] << 16 | (uint32_t)bytes[i + 3] << 24);
+    } else if (encoding.empty()) {
+        for (pugi::xml_node tile : data.children("tile"))
+            gids.push_back(tile.attribute("gid").as_uint());
+    } else {
+        std::cerr << "Unknown layer encoding: " << encoding << std::endl;
+        return false;
+    }
+    if ((int)gids.size() != w * h) {
+        std::cerr << "Layer \"" << layer.attribute("name").as_string() << "\" has " << gids.size()
+                  << " tiles, expected " << w * h << std::endl;
+        return false;
+    }
+    return true;
+}
+
+char tile_for(const std::vector<Tileset>& tilesets, uint32_t gid) {
+    const Tileset* ts = nullptr;
+    for (const Tileset& t : tilesets)
+        if (gid >= t.firstgid && (!ts || t.firstgid > ts->firstgid))
+            ts = &t;
+    if (!ts)
+        return TILE_WALL;
+    const uint32_t id = gid - ts->firstgid;
+    auto it = ts->chars.find(id);
+    if (it != ts->chars.end())
+        return it->second;
+    return id < sizeof(FALLBACK_TILES) ? FALLBACK_TILES[id] : TILE_WALL;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " in.tmx out.mvm" << std::endl;
+        return 1;
+    }
+    const std::string in_path = argv[1];
+    pugi::xml_document doc;
+    pugi::xml_parse_result parsed = doc.load_file(in_path.c_str());
+    if (!parsed) {
+        std::cerr << in_path << ": " << parsed.description() << " at offset " << parsed.offset << std::endl;
+        return 1;
+    }
+    pugi::xml_node map = doc.child("map");
+    const int w = map.attribute("width").as_int(), h = map.attribute("height").as_int();
+    if (!map || w <= 0 || h <= 0 || map.attribute("infinite").as_int() != 0) {
+        std::cerr << in_path << ": not a finite Tiled map" << std::endl;
+        return 1;
+    }
+    const int tile_w = std::max(1, map.attribute("tilewidth").as_int());
+    const int tile_h = std::max(1, map.attribute("tileheight").as_int());
+
+    std::vector<Tileset> tilesets;
+    for (pugi::xml_node node : map.children("tileset")) {
+        Tileset ts;
+        const uint32_t firstgid = node.attribute("firstgid").as_uint();
+        if (node.attribute("source")) {
+            // External tileset, relative to the map
+            const std::string tsx = directory_of(in_path) + node.attribute("source").as_string();
+            pugi::xml_document tsx_doc;
+            pugi::xml_parse_result r = tsx_doc.load_file(tsx.c_str());
+            if (!r) {
+                std::cerr << tsx << ": " << r.description() << std::endl;
+                return 1;
+            }
+            if (!read_tileset(tsx_doc.child("tileset"), firstgid, ts))
+                return 1;
+        } else if (!read_tileset(node, firstgid, ts)) {
+            return 1;
+        }
+        tilesets.push_back(ts);
+    }
+
+    std::vector<std::string> rows(h, std::string(w, TILE_WALL));
+    std::vector<uint32_t> gids;
+    int layers = 0;
+    for (pugi::xml_node layer : map.children("layer")) {
+        if (layer.attribute("visible") && layer.attribute("visible").as_int() == 0)
+            continue;
+        if (!read_layer(layer, w, h, gids))
+            return 1;
+        for (int i = 0; i < w * h; ++i) {
+            const uint32_t gid = gids[i] & GID_MASK;
+            if (gid)
+                rows[i / w][i % w] = tile_for(tilesets, gid);
+        }
+        ++layers;
+    }
+    if (!layers) {
+        std::cerr << in_path << ": no tile layers" << std::endl;
+        return 1;
+    }
+
+    for (pugi::xml_node group : map.children("objectgroup"))
+        for (pugi::xml_node obj : group.children("object")) {
+            std::string kind = obj.attribute("name").as_string();
+            if (kind != "entrance" && kind != "exit")
+                kind = obj.attribute("type") ? obj.attribute("type").as_string() : obj.attribute("class").as_string();
+            if (kind != "entrance" && kind != "exit")
+                continue;
+            const int x = (int)(obj.attribute("x").as_float() / tile_w);
+            const int y = (int)(obj.attribute("y").as_float() / tile_h);
+            if (x >= 0 && x < w && y >= 0 && y < h)
+                rows[y][x] = kind == "entrance" ? TILE_ENTRANCE : TILE_EXIT;
+        }
+
+    set_level_data(rows);
+    if (get_entrance_pos().first < 0 || get_exit_pos().first < 0)
+        std::cerr << in_path << ": warning: no " << (get_entrance_pos().first < 0 ? "entrance" : "exit") << std::endl;
+    if (!save_level_file(argv[2]))
+        return 1;
+    std::cout << "Wrote " << argv[2] << " (" << w << "x" << h << ", " << layers << " layers)" << std::endl;
+    return 0;
+}